@@ -49,7 +49,7 @@ void RecentAppHelper::addAppItem(int index, DockItem *dockItem)
 
     AppItem *appItem = qobject_cast<AppItem *>(dockItem);
 
-    connect(appItem, &AppItem::modeChanged, this, &RecentAppHelper::onModeChanged);
+    connect(appItem, &AppItem::modeChanged, this, &RecentAppHelper::onModeChanged, Qt::UniqueConnection);
 }
 
 void RecentAppHelper::removeAppItem(DockItem *dockItem)
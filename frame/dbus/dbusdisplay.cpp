@@ -16,7 +16,7 @@
  */
 
 DBusDisplay::DBusDisplay(QObject *parent)
-    : QDBusAbstractInterface(staticServiceName(), staticObjectPath(), staticInterfaceName(), QDBusConnection::sessionBus(), parent)
+    : DBusTracedInterface(staticServiceName(), staticObjectPath(), staticInterfaceName(), QDBusConnection::sessionBus(), parent)
 {
     qDBusRegisterMetaType<BrightnessMap>();
     qDBusRegisterMetaType<DisplayRect>();
@@ -11,6 +11,8 @@
 #ifndef DBUSDISPLAY_H_1439948860
 #define DBUSDISPLAY_H_1439948860
 
+#include "dbustracer.h"
+
 #include <QtCore/QObject>
 #include <QtCore/QByteArray>
 #include <QtCore/QList>
@@ -46,7 +48,7 @@ QDebug operator<<(QDebug deg, const DisplayRect &rect);
 /*
  * Proxy class for interface org.deepin.dde.Display1
  */
-class DBusDisplay: public QDBusAbstractInterface
+class DBusDisplay: public DBusTracedInterface
 {
     Q_OBJECT
 
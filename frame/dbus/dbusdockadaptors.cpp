@@ -27,6 +27,8 @@
 #include "pluginsitem.h"
 #include "settingconfig.h"
 #include "customevent.h"
+#include "performancetracer.h"
+#include "dbustracer.h"
 
 #include <DGuiApplicationHelper>
 
@@ -34,6 +36,9 @@
 #include <QDebug>
 #include <QGSettings>
 #include <QDBusMetaType>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
 
 const QSize defaultIconSize = QSize(20, 20);
 
@@ -112,6 +117,17 @@ DBusDockAdaptors::DBusDockAdaptors(WindowManager* parent)
         }
     });
 
+    // 插件图标变化、插件移除和主题变化后，缓存的设置图标失效
+    connect(QuickSettingController::instance(), &QuickSettingController::pluginUpdated, this, [ this ](PluginsItemInterface *itemInter) {
+        removeSettingIconCache(itemInter->pluginName());
+    });
+    connect(QuickSettingController::instance(), &QuickSettingController::pluginRemoved, this, [ this ](PluginsItemInterface *itemInter) {
+        removeSettingIconCache(itemInter->pluginName());
+    });
+    connect(DGuiApplicationHelper::instance(), &DGuiApplicationHelper::themeTypeChanged, this, [ this ] {
+        m_settingIconCache.clear();
+    });
+
     registerPluginInfoMetaType();
 }
 
@@ -182,23 +198,8 @@ DockItemInfos DBusDockAdaptors::plugins()
         info.itemKey = plugin->pluginName();
         info.settingKey = DOCK_QUICK_PLUGINS;
         info.visible = quickSettingKeys.contains(info.itemKey);
-        QSize pixmapSize;
-        QIcon lightIcon = getSettingIcon(plugin, pixmapSize, DGuiApplicationHelper::ColorType::LightType);
-        if (!lightIcon.isNull()) {
-            QBuffer buffer(&info.iconLight);
-            if (buffer.open(QIODevice::WriteOnly)) {
-                QPixmap pixmap = lightIcon.pixmap(pixmapSize);
-                pixmap.save(&buffer, "png");
-            }
-        }
-        QIcon darkIcon = getSettingIcon(plugin, pixmapSize, DGuiApplicationHelper::ColorType::DarkType);
-        if (!darkIcon.isNull()) {
-            QBuffer buffer(&info.iconDark);
-            if (buffer.open(QIODevice::WriteOnly)) {
-                QPixmap pixmap = darkIcon.pixmap(pixmapSize);
-                pixmap.save(&buffer, "png");
-            }
-        }
+        info.iconLight = settingIconData(plugin, DGuiApplicationHelper::ColorType::LightType);
+        info.iconDark = settingIconData(plugin, DGuiApplicationHelper::ColorType::DarkType);
         pluginInfos << info;
     }
 
@@ -280,6 +281,60 @@ void DBusDockAdaptors::setItemOnDock(const QString settingKey, const QString &it
     SETTINGCONFIG->setValue(settingKey, settings);
 }
 
+/**
+ * @brief DBusDockAdaptors::SetTracingEnabled 打开或关闭性能追踪，打开的时候清空之前的记录
+ */
+void DBusDockAdaptors::SetTracingEnabled(bool enabled)
+{
+    if (enabled && !PerformanceTracer::instance()->isEnabled())
+        PerformanceTracer::instance()->clear();
+
+    PerformanceTracer::instance()->setEnabled(enabled);
+}
+
+QString DBusDockAdaptors::GetTracingSummary()
+{
+    return PerformanceTracer::instance()->summary();
+}
+
+/**
+ * @brief DBusDockAdaptors::ExportTrace 导出Chrome trace-event格式的追踪记录
+ * 任何会话总线上的程序都能调用，因此只取文件名，固定写到运行时目录下的dde-dock/trace中
+ * @return 导出的文件的完整路径，失败返回空
+ */
+QString DBusDockAdaptors::ExportTrace(const QString &fileName)
+{
+    const QString name = QFileInfo(fileName).fileName();
+    if (name.isEmpty() || name == "." || name == "..")
+        return QString();
+
+    const QString traceDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + "/dde-dock/trace";
+    if (!QDir().mkpath(traceDir))
+        return QString();
+
+    const QString filePath = traceDir + "/" + name;
+    if (!PerformanceTracer::instance()->exportTrace(filePath))
+        return QString();
+
+    return filePath;
+}
+
+/**
+ * @brief DBusDockAdaptors::GetDBusStats 任务栏发出的DBus调用的统计信息(json)
+ */
+QString DBusDockAdaptors::GetDBusStats()
+{
+    return DBusTracer::instance()->summary();
+}
+
+/**
+ * @brief DBusDockAdaptors::GetPluginSettingsStats 插件配置批量写入daemon的统计信息(json)
+ */
+QString DBusDockAdaptors::GetPluginSettingsStats()
+{
+    return qApp->property(PROP_PLUGIN_SETTINGS_STATISTICS).toString();
+}
+
 QRect DBusDockAdaptors::geometry() const
 {
     return m_windowManager->geometry();
@@ -322,6 +377,43 @@ QList<PluginsItemInterface *> DBusDockAdaptors::localPlugins() const
     return QuickSettingController::instance()->pluginInSettings();
 }
 
+/**
+ * @brief DBusDockAdaptors::settingIconData 插件在控制中心设置页面中的图标(png格式)
+ * 按照(插件, 主题, 缩放比例)缓存，控制中心每次获取插件列表时不需要重新绘制和编码
+ */
+QByteArray DBusDockAdaptors::settingIconData(PluginsItemInterface *plugin, DGuiApplicationHelper::ColorType colorType)
+{
+    const QString key = QString("%1/%2/%3").arg(plugin->pluginName()).arg(colorType).arg(qApp->devicePixelRatio());
+    auto it = m_settingIconCache.constFind(key);
+    if (it != m_settingIconCache.constEnd())
+        return it.value();
+
+    QByteArray data;
+    QSize pixmapSize;
+    QIcon icon = getSettingIcon(plugin, pixmapSize, colorType);
+    if (!icon.isNull()) {
+        QBuffer buffer(&data);
+        if (buffer.open(QIODevice::WriteOnly)) {
+            QPixmap pixmap = icon.pixmap(pixmapSize);
+            pixmap.save(&buffer, "png");
+        }
+    }
+
+    m_settingIconCache.insert(key, data);
+    return data;
+}
+
+void DBusDockAdaptors::removeSettingIconCache(const QString &pluginName)
+{
+    const QString prefix = pluginName + "/";
+    for (auto it = m_settingIconCache.begin(); it != m_settingIconCache.end();) {
+        if (it.key().startsWith(prefix))
+            it = m_settingIconCache.erase(it);
+        else
+            ++it;
+    }
+}
+
 QIcon DBusDockAdaptors::getSettingIcon(PluginsItemInterface *plugin, QSize &pixmapSize, DGuiApplicationHelper::ColorType colorType) const
 {
     auto iconSize = [](const QIcon &icon) {
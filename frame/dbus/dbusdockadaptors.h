@@ -94,6 +94,22 @@ class DBusDockAdaptors: public QDBusAbstractAdaptor
                                        "        <arg name=\"itemKey\" type=\"s\" direction=\"in\"/>"
                                        "        <arg name=\"visible\" type=\"b\" direction=\"in\"/>"
                                        "    </method>"
+                                       "    <method name=\"SetTracingEnabled\">"
+                                       "        <arg name=\"enabled\" type=\"b\" direction=\"in\"/>"
+                                       "    </method>"
+                                       "    <method name=\"GetTracingSummary\">"
+                                       "        <arg name=\"summary\" type=\"s\" direction=\"out\"/>"
+                                       "    </method>"
+                                       "    <method name=\"ExportTrace\">"
+                                       "        <arg name=\"fileName\" type=\"s\" direction=\"in\"/>"
+                                       "        <arg name=\"filePath\" type=\"s\" direction=\"out\"/>"
+                                       "    </method>"
+                                       "    <method name=\"GetDBusStats\">"
+                                       "        <arg name=\"stats\" type=\"s\" direction=\"out\"/>"
+                                       "    </method>"
+                                       "    <method name=\"GetPluginSettingsStats\">"
+                                       "        <arg name=\"stats\" type=\"s\" direction=\"out\"/>"
+                                       "    </method>"
                                        "    <signal name=\"pluginVisibleChanged\">"
                                        "        <arg type=\"s\"/>"
                                        "        <arg type=\"b\"/>"
@@ -122,6 +138,12 @@ public Q_SLOTS: // METHODS
     void setPluginVisible(const QString &pluginName, bool visible);
     void setItemOnDock(const QString settingKey, const QString &itemKey, bool visible);
 
+    void SetTracingEnabled(bool enabled);
+    QString GetTracingSummary();
+    QString ExportTrace(const QString &fileName);
+    QString GetDBusStats();
+    QString GetPluginSettingsStats();
+
 public: // PROPERTIES
     QRect geometry() const;
 
@@ -137,10 +159,13 @@ private:
     bool isPluginValid(const QString &name);
     QList<PluginsItemInterface *> localPlugins() const;
     QIcon getSettingIcon(PluginsItemInterface *plugin, QSize &pixmapSize, DGuiApplicationHelper::ColorType colorType) const;
+    QByteArray settingIconData(PluginsItemInterface *plugin, DGuiApplicationHelper::ColorType colorType);
+    void removeSettingIconCache(const QString &pluginName);
 
 private:
     QGSettings *m_gsettings;
     WindowManager *m_windowManager;
+    QHash<QString, QByteArray> m_settingIconCache;      // key为"插件名/主题/缩放比例"
 };
 
 #endif //DBUSDOCKADAPTORS
@@ -37,7 +37,7 @@
  */
 
 DBusMenu::DBusMenu(const QString &path, QObject *parent)
-    : QDBusAbstractInterface(staticServerPath(), path, staticInterfaceName(), QDBusConnection::sessionBus(), parent)
+    : DBusTracedInterface(staticServerPath(), path, staticInterfaceName(), QDBusConnection::sessionBus(), parent)
 {
 }
 
@@ -32,6 +32,8 @@
 #ifndef DBUSMENU_H_1436158836
 #define DBUSMENU_H_1436158836
 
+#include "dbustracer.h"
+
 #include <QtCore/QObject>
 #include <QtCore/QByteArray>
 #include <QtCore/QList>
@@ -44,7 +46,7 @@
 /*
  * Proxy class for interface com.deepin.menu.Menu
  */
-class DBusMenu: public QDBusAbstractInterface
+class DBusMenu: public DBusTracedInterface
 {
     Q_OBJECT
 public:
@@ -37,7 +37,7 @@
  */
 
 DBusMenuManager::DBusMenuManager(QObject *parent)
-    : QDBusAbstractInterface(staticServerPath(), staticInterfacePath(), staticInterfaceName(), QDBusConnection::sessionBus(), parent)
+    : DBusTracedInterface(staticServerPath(), staticInterfacePath(), staticInterfaceName(), QDBusConnection::sessionBus(), parent)
 {
 }
 
@@ -32,6 +32,8 @@
 #ifndef DBUSMENUMANAGER_H_1436158928
 #define DBUSMENUMANAGER_H_1436158928
 
+#include "dbustracer.h"
+
 #include <QtCore/QObject>
 #include <QtCore/QByteArray>
 #include <QtCore/QList>
@@ -44,7 +46,7 @@
 /*
  * Proxy class for interface com.deepin.menu.Manager
  */
-class DBusMenuManager: public QDBusAbstractInterface
+class DBusMenuManager: public DBusTracedInterface
 {
     Q_OBJECT
 public:
@@ -0,0 +1,164 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "dbustracer.h"
+#include "constants.h"
+
+#include <QCoreApplication>
+#include <QDBusPendingCallWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+#include <algorithm>
+
+// 耗时分布的上限(微秒)，最后一档为超过500ms的调用
+static const qint64 HistogramBounds[] = { 100, 500, 1000, 5000, 10000, 50000, 100000, 500000 };
+static const int HistogramSize = sizeof(HistogramBounds) / sizeof(HistogramBounds[0]) + 1;
+
+static int histogramIndex(qint64 usecs)
+{
+    return static_cast<int>(std::upper_bound(std::begin(HistogramBounds), std::end(HistogramBounds), usecs - 1) - std::begin(HistogramBounds));
+}
+
+DBusTracer::DBusTracer()
+{
+}
+
+/**
+ * @brief DBusTracer::instance 任务栏和插件中各自有一份DBusTracer的代码，第一次使用的模块创建实例并记录在qApp的属性中，
+ * 其他模块使用同一个实例，这样插件中的调用也能在GetDBusStats中看到
+ */
+DBusTracer *DBusTracer::instance()
+{
+    static DBusTracer *tracer = [] {
+        if (!qApp)
+            return new DBusTracer;
+
+        const QVariant value = qApp->property(PROP_DBUS_TRACER);
+        if (value.isValid())
+            return static_cast<DBusTracer *>(value.value<void *>());
+
+        DBusTracer *sharedTracer = new DBusTracer;
+        qApp->setProperty(PROP_DBUS_TRACER, QVariant::fromValue(static_cast<void *>(sharedTracer)));
+        return sharedTracer;
+    }();
+
+    return tracer;
+}
+
+static bool isMainThread()
+{
+    return qApp && QThread::currentThread() == qApp->thread();
+}
+
+void DBusTracer::record(const QString &service, const QString &interface, const QString &member, CallMode mode, qint64 usecs)
+{
+    record(service, interface, member, mode, usecs, isMainThread());
+}
+
+void DBusTracer::record(const QString &service, const QString &interface, const QString &member, CallMode mode, qint64 usecs, bool mainThread)
+{
+    const QString key = QString("%1 %2.%3").arg(service).arg(interface).arg(member);
+
+    QMutexLocker locker(&m_mutex);
+    Statistics &statistics = m_statistics[key];
+    if (statistics.syncHistogram.isEmpty()) {
+        statistics.syncHistogram.fill(0, HistogramSize);
+        statistics.asyncHistogram.fill(0, HistogramSize);
+    }
+
+    if (mode == Sync) {
+        statistics.syncCount++;
+        statistics.syncTotal += usecs;
+        statistics.syncHistogram[histogramIndex(usecs)]++;
+    } else {
+        statistics.asyncCount++;
+        statistics.asyncTotal += usecs;
+        statistics.asyncHistogram[histogramIndex(usecs)]++;
+    }
+
+    if (mainThread)
+        statistics.mainThreadCount++;
+
+    statistics.max = qMax(statistics.max, usecs);
+}
+
+/**
+ * @brief DBusTracer::watch 在异步调用返回的时候记录从发出到返回的时间
+ */
+QDBusPendingCall DBusTracer::watch(const QDBusPendingCall &call, const QString &service, const QString &interface, const QString &member)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 调用所在的线程在发出调用的时候确定
+    const bool mainThread = isMainThread();
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, watcher, [ = ] {
+        record(service, interface, member, Async, timer.nsecsElapsed() / 1000, mainThread);
+        watcher->deleteLater();
+    });
+
+    return call;
+}
+
+void DBusTracer::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_statistics.clear();
+}
+
+/**
+ * @brief DBusTracer::summary 按照同步调用的总耗时从大到小排列的统计信息
+ */
+QString DBusTracer::summary() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QList<QString> keys = m_statistics.keys();
+    std::sort(keys.begin(), keys.end(), [ this ](const QString &a, const QString &b) {
+        const Statistics &sa = m_statistics[a];
+        const Statistics &sb = m_statistics[b];
+        if (sa.syncTotal != sb.syncTotal)
+            return sa.syncTotal > sb.syncTotal;
+        return sa.asyncTotal > sb.asyncTotal;
+    });
+
+    QJsonArray bounds;
+    for (qint64 bound : HistogramBounds)
+        bounds.append(bound);
+
+    QJsonArray calls;
+    for (const QString &key : keys) {
+        const Statistics &statistics = m_statistics[key];
+
+        QJsonArray syncHistogram;
+        QJsonArray asyncHistogram;
+        for (int i = 0; i < HistogramSize; ++i) {
+            syncHistogram.append(statistics.syncHistogram.at(i));
+            asyncHistogram.append(statistics.asyncHistogram.at(i));
+        }
+
+        QJsonObject object;
+        object["call"] = key;
+        object["sync_count"] = statistics.syncCount;
+        object["async_count"] = statistics.asyncCount;
+        object["main_thread_count"] = statistics.mainThreadCount;
+        object["other_thread_count"] = statistics.syncCount + statistics.asyncCount - statistics.mainThreadCount;
+        object["sync_total_us"] = statistics.syncTotal;
+        object["async_total_us"] = statistics.asyncTotal;
+        object["max_us"] = statistics.max;
+        object["sync_histogram"] = syncHistogram;
+        object["async_histogram"] = asyncHistogram;
+        calls.append(object);
+    }
+
+    QJsonObject root;
+    root["histogram_bounds_us"] = bounds;
+    root["calls"] = calls;
+    return QString::fromUtf8(QJsonDocument(root).toJson(QJsonDocument::Indented));
+}
@@ -0,0 +1,170 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DBUSTRACER_H
+#define DBUSTRACER_H
+
+#include <DDBusExtendedAbstractInterface>
+
+#include <QDBusAbstractInterface>
+#include <QDBusPendingCall>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+
+#include <utility>
+
+/** 统计任务栏发出的DBus调用
+ * @brief The DBusTracer class
+ * 按照(服务, 接口, 方法)统计调用次数、同步还是异步、调用所在的线程以及耗时的分布，
+ * 通过org.deepin.dde.Dock1的GetDBusStats接口获取，用来找出还在阻塞主线程的DBus调用
+ * 插件中也各自编译了这个类，instance()通过qApp的属性让整个进程共用一个实例，插件中的调用也会汇总到GetDBusStats中
+ */
+class DBusTracer
+{
+public:
+    enum CallMode {
+        Sync,
+        Async
+    };
+
+    static DBusTracer *instance();
+
+    void record(const QString &service, const QString &interface, const QString &member, CallMode mode, qint64 usecs);
+    QDBusPendingCall watch(const QDBusPendingCall &call, const QString &service, const QString &interface, const QString &member);
+    void reset();
+    QString summary() const;
+
+private:
+    DBusTracer();
+    DBusTracer(const DBusTracer &) = delete;
+    DBusTracer &operator=(const DBusTracer &) = delete;
+
+    void record(const QString &service, const QString &interface, const QString &member, CallMode mode, qint64 usecs, bool mainThread);
+
+    struct Statistics {
+        int syncCount = 0;
+        int asyncCount = 0;
+        int mainThreadCount = 0;                        // 在主线程中调用的次数，其余为在其他线程中调用
+        qint64 syncTotal = 0;
+        qint64 asyncTotal = 0;
+        qint64 max = 0;
+        QVector<int> syncHistogram;
+        QVector<int> asyncHistogram;
+    };
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Statistics> m_statistics;            // key为"服务 接口.方法"
+};
+
+/** 带有调用统计的DBus接口基类
+ * @brief The DBusTraced class
+ * 接口类中的property()/setProperty()/call()/asyncCall()/callWithArgumentList()/asyncCallWithArgumentList()
+ * 以及DDBusExtendedAbstractInterface的internalPropGet()/internalPropSet()会使用这里的同名函数，在调用的同时记录到DBusTracer中。
+ * 这些函数在Qt和DTK中都不是虚函数，只有通过接口类本身调用的时候才会被统计，
+ * 手写的接口类从DBusTracedInterface派生，qdbusxml2cpp-fix生成的接口类在generation_dbus_interface中被改为从DBusTracedExtendedInterface派生
+ */
+template <class Interface>
+class DBusTraced : public Interface
+{
+public:
+    DBusTraced(const QString &service, const QString &path, const char *interface, const QDBusConnection &connection, QObject *parent)
+        : Interface(service, path, interface, connection, parent)
+    {
+    }
+
+    QVariant property(const char *name) const
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        // 读取DBus属性是同步的Properties.Get调用
+        const QVariant value = Interface::property(name);
+        DBusTracer::instance()->record(this->service(), this->interface(), QString("Get(%1)").arg(name), DBusTracer::Sync, timer.nsecsElapsed() / 1000);
+
+        return value;
+    }
+
+    bool setProperty(const char *name, const QVariant &value)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        const bool result = Interface::setProperty(name, value);
+        DBusTracer::instance()->record(this->service(), this->interface(), QString("Set(%1)").arg(name), DBusTracer::Sync, timer.nsecsElapsed() / 1000);
+
+        return result;
+    }
+
+    template <typename... Args>
+    QDBusMessage call(const QString &method, Args &&...args)
+    {
+        return callWithArgumentList(QDBus::AutoDetect, method, { QVariant(std::forward<Args>(args))... });
+    }
+
+    template <typename... Args>
+    QDBusMessage call(QDBus::CallMode mode, const QString &method, Args &&...args)
+    {
+        return callWithArgumentList(mode, method, { QVariant(std::forward<Args>(args))... });
+    }
+
+    template <typename... Args>
+    QDBusPendingCall asyncCall(const QString &method, Args &&...args)
+    {
+        return asyncCallWithArgumentList(method, { QVariant(std::forward<Args>(args))... });
+    }
+
+    QDBusPendingCall asyncCallWithArgumentList(const QString &method, const QList<QVariant> &args)
+    {
+        return DBusTracer::instance()->watch(Interface::asyncCallWithArgumentList(method, args), this->service(), this->interface(), method);
+    }
+
+    QDBusMessage callWithArgumentList(QDBus::CallMode mode, const QString &method, const QList<QVariant> &args)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        const QDBusMessage reply = Interface::callWithArgumentList(mode, method, args);
+        DBusTracer::instance()->record(this->service(), this->interface(), method, DBusTracer::Sync, timer.nsecsElapsed() / 1000);
+
+        return reply;
+    }
+
+protected:
+    // 以下两个函数只有DDBusExtendedAbstractInterface中有，生成的接口类通过它们读写属性
+    QVariant internalPropGet(const char *name, void *propertyPtr)
+    {
+        // 使用缓存的时候不会发出DBus调用
+        if (this->useCache())
+            return Interface::internalPropGet(name, propertyPtr);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const QVariant value = Interface::internalPropGet(name, propertyPtr);
+        // 异步模式下返回的是上次的值，只能记录发出请求的耗时
+        DBusTracer::instance()->record(this->service(), this->interface(), QString("Get(%1)").arg(name),
+                                       this->sync() ? DBusTracer::Sync : DBusTracer::Async, timer.nsecsElapsed() / 1000);
+
+        return value;
+    }
+
+    void internalPropSet(const char *name, const QVariant &value, void *propertyPtr)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        Interface::internalPropSet(name, value, propertyPtr);
+        DBusTracer::instance()->record(this->service(), this->interface(), QString("Set(%1)").arg(name),
+                                       this->sync() ? DBusTracer::Sync : DBusTracer::Async, timer.nsecsElapsed() / 1000);
+    }
+};
+
+typedef DBusTraced<QDBusAbstractInterface> DBusTracedInterface;
+typedef DBusTraced<DTK_CORE_NAMESPACE::DDBusExtendedAbstractInterface> DBusTracedExtendedInterface;
+
+#endif // DBUSTRACER_H
@@ -20,6 +20,7 @@
  */
 
 #include "dockinterface.h"
+#include "performancetracer.h"
 
 #include "org_deepin_dde_daemon_dock1.h"
 
@@ -28,6 +29,8 @@
 // 否则会出现重复定义的错误
 #define DOCKRECT_H
 
+#define BLOCKING_LOG_INTERVAL (10 * 1000)       // 同步读取属性的日志最多每10秒打印一次
+
 /*
  * Implementation of interface class __Dock
  */
@@ -37,21 +40,14 @@ class DockPrivate
 public:
    DockPrivate() = default;
 
-    // begin member variables
-    int DisplayMode;
-    QStringList DockedApps;
-    QList<QDBusObjectPath> Entries;
-    DockRect FrontendWindowRect;
-    int HideMode;
-    int HideState;
-    uint HideTimeout;
-    uint IconSize;
-    double Opacity;
-    int Position;
-    uint ShowTimeout;
-    uint WindowSize;
-    uint WindowSizeEfficient;
-    uint WindowSizeFashion;
+    // 后端属性的本地缓存，通过GetAll初始化，PropertiesChanged信号更新
+    QVariantMap properties;
+    bool propertiesReady = false;
+    // GetAll失败后在后端服务重新注册之前不再同步获取，避免每次读取都阻塞在失败的调用上
+    bool getAllFailed = false;
+    // 没有命中缓存的同步读取次数，用于调试
+    int blockingReads = 0;
+    QElapsedTimer blockingLogTime;
 
 public:
     QMap<QString, QDBusPendingCallWatcher *> m_processingCalls;
@@ -65,7 +61,7 @@ using DockInter = org::deepin::dde::daemon::Dock1;
  * @brief 任务栏的部分DBUS接口是通过窗管获取的，由于AM后端并未提供窗管的相关接口，因此，
  * 此处先将窗管的接口集成进来，作为私有类，只提供任务栏接口使用
  */
-class WM : public QDBusAbstractInterface
+class WM : public DBusTracedInterface
 {
 public:
     static inline const char *staticInterfaceName()
@@ -104,7 +100,7 @@ private:
 };
 
 WM::WM(const QString &service, const QString &path, const QDBusConnection &connection, QObject *parent)
-    : QDBusAbstractInterface(service, path, staticInterfaceName(), connection, parent)
+    : DBusTracedInterface(service, path, staticInterfaceName(), connection, parent)
     , m_dockInter(new DockInter("org.deepin.dde.daemon.Dock1", "/org/deepin/dde/daemon/Dock1", QDBusConnection::sessionBus(), this))
 {
 }
@@ -114,7 +110,7 @@ WM::~WM()
 }
 
 Dde_Dock::Dde_Dock(const QString &service, const QString &path, const QDBusConnection &connection, QObject *parent)
-    : QDBusAbstractInterface(service, path, staticInterfaceName(), connection, parent)
+    : DBusTracedInterface(service, path, staticInterfaceName(), connection, parent)
     , d_ptr(new DockPrivate)
     , m_wm(new WM("com.deepin.wm", "/com/deepin/wm", QDBusConnection::sessionBus(), this))
 {
@@ -126,6 +122,12 @@ Dde_Dock::Dde_Dock(const QString &service, const QString &path, const QDBusConne
 
     if (QMetaType::type("DockRect") == QMetaType::UnknownType)
         registerDockRectMetaType();
+
+    // 后端服务重启后重新获取所有的属性
+    QDBusServiceWatcher *serviceWatcher = new QDBusServiceWatcher(service, connection, QDBusServiceWatcher::WatchForRegistration, this);
+    connect(serviceWatcher, &QDBusServiceWatcher::serviceRegistered, this, &Dde_Dock::onServiceRegistered);
+
+    requestAllProperties();
 }
 
 Dde_Dock::~Dde_Dock()
@@ -145,145 +147,297 @@ void Dde_Dock::onPropertyChanged(const QDBusMessage& msg)
         return;
 
     QVariantMap changedProps = qdbus_cast<QVariantMap>(arguments.at(1).value<QDBusArgument>());
-    QStringList keys = changedProps.keys();
-    foreach(const QString &prop, keys) {
-    const QMetaObject* self = metaObject();
-        for (int i=self->propertyOffset(); i < self->propertyCount(); ++i) {
-            QMetaProperty p = self->property(i);
-            if (p.name() == prop)
-                Q_EMIT p.notifySignal().invoke(this);
+    // 没有开启跟踪时不拼接字符串
+    PerformanceTracer *tracer = PerformanceTracer::instance();
+    if (tracer->isEnabled())
+        tracer->markDBusSignal(QString("Dock1.%1").arg(changedProps.keys().join(',')));
+    updateProperties(changedProps, NotifyAll);
+}
+
+void Dde_Dock::onServiceRegistered()
+{
+    d_ptr->getAllFailed = false;
+    requestAllProperties();
+}
+
+/**
+ * @brief Dde_Dock::requestAllProperties 异步获取后端的所有属性，用来初始化本地的缓存
+ */
+void Dde_Dock::requestAllProperties()
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(service(), path(), "org.freedesktop.DBus.Properties", "GetAll");
+    msg << QString(staticInterfaceName());
+
+    const QDBusPendingCall call = DBusTracer::instance()->watch(connection().asyncCall(msg), service(), "org.freedesktop.DBus.Properties", "GetAll");
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &Dde_Dock::onGetAllPropertiesFinished);
+}
+
+void Dde_Dock::onGetAllPropertiesFinished(QDBusPendingCallWatcher *w)
+{
+    w->deleteLater();
+
+    QDBusPendingReply<QVariantMap> reply = *w;
+    if (reply.isError()) {
+        qWarning() << "get dock properties failed:" << reply.error().message();
+        d_ptr->getAllFailed = true;
+        return;
+    }
+
+    // 在返回之前已经同步获取过的属性，如果有变化需要通知出去
+    d_ptr->propertiesReady = true;
+    updateProperties(reply.value(), NotifyChanged);
+}
+
+/**
+ * @brief Dde_Dock::updateProperties 更新本地缓存的属性，属性值发生变化的时候发出对应的信号
+ * @param notify NotifyAll: 后端通知的属性变化，NotifyChanged: 只通知缓存中已有并且发生了变化的属性
+ */
+void Dde_Dock::updateProperties(const QVariantMap &properties, PropertyNotify notify)
+{
+    // 属性名到属性索引的表只需要建立一次，避免每次变化都按名称逐个比较所有的属性
+    const QMetaObject *self = &staticMetaObject;
+    static const QHash<QString, int> propertyIndexes = [ self ] {
+        QHash<QString, int> indexes;
+        for (int i = self->propertyOffset(); i < self->propertyCount(); ++i)
+            indexes.insert(QString::fromLatin1(self->property(i).name()), i);
+        return indexes;
+    }();
+
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        const int index = propertyIndexes.value(it.key(), -1);
+        if (index < 0)
+            continue;
+
+        const QMetaProperty metaProperty = self->property(index);
+        QVariant value = it.value();
+        if (value.userType() == qMetaTypeId<QDBusArgument>()) {
+            // 复杂类型(比如DockRect、ao)需要按照属性的类型解析
+            QVariant result(metaProperty.userType(), nullptr);
+            if (!QDBusMetaType::demarshall(qvariant_cast<QDBusArgument>(value), metaProperty.userType(), result.data()))
+                continue;
+            value = result;
+        } else if (value.userType() != metaProperty.userType()) {
+            value.convert(metaProperty.userType());
+        }
+
+        const bool existed = d_ptr->properties.contains(it.key());
+        if (existed && d_ptr->properties.value(it.key()) == value)
+            continue;
+
+        d_ptr->properties.insert(it.key(), value);
+
+        if (!metaProperty.hasNotifySignal() || notify == NotifyNone || (notify == NotifyChanged && !existed))
+            continue;
+
+        metaProperty.notifySignal().invoke(this, Qt::DirectConnection, QGenericArgument(value.typeName(), value.constData()));
+    }
+}
+
+/**
+ * @brief Dde_Dock::cachedProperty 从本地缓存中读取属性，不会阻塞在DBus调用上
+ * 只有在GetAll还没有返回的时候(启动阶段)，或者后端没有提供这个属性的时候，才会同步获取一次，并计入blockingReadCount
+ * GetAll失败后直到后端服务重新注册都只获取单个属性，和没有缓存时一样每次读取只有一次同步调用
+ */
+QVariant Dde_Dock::cachedProperty(const char *name) const
+{
+    const QString key = QString::fromLatin1(name);
+    auto it = d_ptr->properties.constFind(key);
+    if (it != d_ptr->properties.constEnd())
+        return it.value();
+
+    // 后端不可用时绘制等过程中会频繁读取，限制日志的频率
+    d_ptr->blockingReads++;
+    if (!d_ptr->blockingLogTime.isValid() || d_ptr->blockingLogTime.elapsed() > BLOCKING_LOG_INTERVAL) {
+        qDebug() << "blocking read of dock property:" << name << "count:" << d_ptr->blockingReads;
+        d_ptr->blockingLogTime.start();
+    }
+
+    Dde_Dock *self = const_cast<Dde_Dock *>(this);
+    if (!d_ptr->propertiesReady && !d_ptr->getAllFailed) {
+        // 缓存还没有准备好，同步获取一次所有的属性，之后的读取都从缓存中读
+        QDBusMessage msg = QDBusMessage::createMethodCall(service(), path(), "org.freedesktop.DBus.Properties", "GetAll");
+        msg << QString(staticInterfaceName());
+        QElapsedTimer timer;
+        timer.start();
+        QDBusReply<QVariantMap> reply = connection().call(msg);
+        DBusTracer::instance()->record(service(), "org.freedesktop.DBus.Properties", "GetAll", DBusTracer::Sync, timer.nsecsElapsed() / 1000);
+        // 获取失败时缓存仍然没有准备好，后端服务重新注册后再试
+        if (reply.isValid()) {
+            d_ptr->propertiesReady = true;
+            self->updateProperties(reply.value(), NotifyNone);
+        } else {
+            d_ptr->getAllFailed = true;
         }
+
+        it = d_ptr->properties.constFind(key);
+        if (it != d_ptr->properties.constEnd())
+            return it.value();
+    }
+
+    // 后端没有这个属性，单独获取一次，获取成功时缓存下来避免重复的同步调用
+    const QVariant value = property(name);
+    if (value.isValid())
+        d_ptr->properties.insert(key, value);
+
+    return value;
+}
+
+int Dde_Dock::blockingReadCount() const
+{
+    return d_ptr->blockingReads;
+}
+
+/**
+ * @brief Dde_Dock::setDaemonProperty 设置后端的属性，成功后立即更新本地缓存并发出变化信号，
+ * 调用者接下来读取到的就是新的值，之后收到的PropertiesChanged因为值相同不会重复通知
+ */
+void Dde_Dock::setDaemonProperty(const char *name, const QVariant &value)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(service(), path(), "org.freedesktop.DBus.Properties", "Set");
+    msg << QString(staticInterfaceName()) << QString::fromLatin1(name) << QVariant::fromValue(QDBusVariant(value));
+
+    QElapsedTimer timer;
+    timer.start();
+    const QDBusMessage reply = connection().call(msg);
+    DBusTracer::instance()->record(service(), interface(), QString("Set(%1)").arg(name), DBusTracer::Sync, timer.nsecsElapsed() / 1000);
+
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        qWarning() << "set dock property failed:" << name << reply.errorMessage();
+        return;
     }
+
+    updateProperties({ { QString::fromLatin1(name), value } }, NotifyAll);
 }
 
 int Dde_Dock::displayMode()
 {
-    return qvariant_cast<int>(property("DisplayMode"));
+    return qvariant_cast<int>(cachedProperty("DisplayMode"));
 }
 
 void Dde_Dock::setDisplayMode(int value)
 {
-    setProperty("DisplayMode", QVariant::fromValue(value));
+    setDaemonProperty("DisplayMode", QVariant::fromValue(value));
 }
 
 QStringList Dde_Dock::dockedApps()
 {
-    return qvariant_cast<QStringList>(property("DockedApps"));
+    return qvariant_cast<QStringList>(cachedProperty("DockedApps"));
 }
 
 QList<QDBusObjectPath> Dde_Dock::entries()
 {
-    return qvariant_cast<QList<QDBusObjectPath>>(property("Entries"));
+    return qvariant_cast<QList<QDBusObjectPath>>(cachedProperty("Entries"));
 }
 
 DockRect Dde_Dock::frontendWindowRect()
 {
-    return qvariant_cast<DockRect>(property("FrontendWindowRect"));
+    return qvariant_cast<DockRect>(cachedProperty("FrontendWindowRect"));
 }
 
 int Dde_Dock::hideMode()
 {
-    return qvariant_cast<int>(property("HideMode"));
+    return qvariant_cast<int>(cachedProperty("HideMode"));
 }
 
 void Dde_Dock::setHideMode(int value)
 {
-   internalPropSet("HideMode", QVariant::fromValue(value));
+    setDaemonProperty("HideMode", QVariant::fromValue(value));
 }
 
 int Dde_Dock::hideState()
 {
-    return qvariant_cast<int>(property("HideState"));
+    return qvariant_cast<int>(cachedProperty("HideState"));
 }
 
 uint Dde_Dock::hideTimeout()
 {
-    return qvariant_cast<uint>(property("HideTimeout"));
+    return qvariant_cast<uint>(cachedProperty("HideTimeout"));
 }
 
 void Dde_Dock::setHideTimeout(uint value)
 {
-   setProperty("HideTimeout", QVariant::fromValue(value));
+    setDaemonProperty("HideTimeout", QVariant::fromValue(value));
 }
 
 uint Dde_Dock::iconSize()
 {
-    return qvariant_cast<uint>(property("IconSize"));
+    return qvariant_cast<uint>(cachedProperty("IconSize"));
 }
 
 void Dde_Dock::setIconSize(uint value)
 {
-   setProperty("IconSize", QVariant::fromValue(value));
+    setDaemonProperty("IconSize", QVariant::fromValue(value));
 }
 
 double Dde_Dock::opacity()
 {
-    return qvariant_cast<double>(property("Opacity"));
+    return qvariant_cast<double>(cachedProperty("Opacity"));
 }
 
 void Dde_Dock::setOpacity(double value)
 {
-   setProperty("Opacity", QVariant::fromValue(value));
+    setDaemonProperty("Opacity", QVariant::fromValue(value));
 }
 
 int Dde_Dock::position()
 {
-    return qvariant_cast<int>(property("Position"));
+    return qvariant_cast<int>(cachedProperty("Position"));
 }
 
 void Dde_Dock::setPosition(int value)
 {
-   setProperty("Position", QVariant::fromValue(value));
+    setDaemonProperty("Position", QVariant::fromValue(value));
 }
 
 uint Dde_Dock::showTimeout()
 {
-    return qvariant_cast<uint>(property("ShowTimeout"));
+    return qvariant_cast<uint>(cachedProperty("ShowTimeout"));
 }
 
 void Dde_Dock::setShowTimeout(uint value)
 {
-   setProperty("ShowTimeout", QVariant::fromValue(value));
+    setDaemonProperty("ShowTimeout", QVariant::fromValue(value));
 }
 
 uint Dde_Dock::windowSize()
 {
-    return qvariant_cast<uint>(property("WindowSize"));
+    return qvariant_cast<uint>(cachedProperty("WindowSize"));
 }
 
 void Dde_Dock::setWindowSize(uint value)
 {
-   setProperty("WindowSize", QVariant::fromValue(value));
+    setDaemonProperty("WindowSize", QVariant::fromValue(value));
 }
 
 uint Dde_Dock::windowSizeEfficient()
 {
-    return qvariant_cast<uint>(property("WindowSizeEfficient"));
+    return qvariant_cast<uint>(cachedProperty("WindowSizeEfficient"));
 }
 
 void Dde_Dock::setWindowSizeEfficient(uint value)
 {
-   setProperty("WindowSizeEfficient", QVariant::fromValue(value));
+    setDaemonProperty("WindowSizeEfficient", QVariant::fromValue(value));
 }
 
 uint Dde_Dock::windowSizeFashion()
 {
-    return qvariant_cast<uint>(property("WindowSizeFashion"));
+    return qvariant_cast<uint>(cachedProperty("WindowSizeFashion"));
 }
 
 void Dde_Dock::setWindowSizeFashion(uint value)
 {
-    setProperty("WindowSizeFashion", QVariant::fromValue(value));
+    setDaemonProperty("WindowSizeFashion", QVariant::fromValue(value));
 }
 
 bool Dde_Dock::showRecent() const
 {
-    return qvariant_cast<bool>(property("ShowRecent"));
+    return qvariant_cast<bool>(cachedProperty("ShowRecent"));
 }
 
 bool Dde_Dock::showMultiWindow() const
 {
-    return qvariant_cast<bool>(property("ShowMultiWindow"));
+    return qvariant_cast<bool>(cachedProperty("ShowMultiWindow"));
 }
 
 QDBusPendingReply<> Dde_Dock::ActivateWindow(uint in0)
@@ -23,6 +23,7 @@
 #define DOCK_INTERFACE
 
 #include "types/dockrect.h"
+#include "dbustracer.h"
 
 #include <QObject>
 #include <QByteArray>
@@ -41,7 +42,7 @@ class WM;
 
 void registerDockRectMetaType();
 
-class Dde_Dock : public QDBusAbstractInterface
+class Dde_Dock : public DBusTracedInterface
 {
     Q_OBJECT
 
@@ -112,6 +113,8 @@ public:
     Q_PROPERTY(bool ShowMultiWindow READ showMultiWindow NOTIFY ShowMultiWindowChanged)
     bool showMultiWindow() const;
 
+    int blockingReadCount() const;
+
 public Q_SLOTS: // METHODS
     QDBusPendingReply<> ActivateWindow(uint in0);
 
@@ -318,6 +321,20 @@ public Q_SLOTS:
 private Q_SLOTS:
     void onPendingCallFinished(QDBusPendingCallWatcher *w);
     void onPropertyChanged(const QDBusMessage& msg);
+    void onServiceRegistered();
+    void requestAllProperties();
+    void onGetAllPropertiesFinished(QDBusPendingCallWatcher *w);
+
+private:
+    enum PropertyNotify {
+        NotifyNone,
+        NotifyChanged,
+        NotifyAll
+    };
+
+    void updateProperties(const QVariantMap &properties, PropertyNotify notify);
+    QVariant cachedProperty(const char *name) const;
+    void setDaemonProperty(const char *name, const QVariant &value);
 
 private:
     DockPrivate *d_ptr;
@@ -20,6 +20,7 @@
  */
 
 #include "entryinterface.h"
+#include "performancetracer.h"
 
 /*
  * Implementation of interface class __Entry
@@ -76,6 +77,40 @@ bool WindowInfo::operator==(const WindowInfo &rhs) const
            uuid == rhs.uuid);
 }
 
+// 需要同步的属性：属性名、类型、是否需要和旧值比较
+// WindowInfos只在后端窗口变化的时候才会通知，不再逐个比较所有的窗口信息
+#define ENTRY_PROPERTIES(X) \
+    X(CurrentWindow, uint, true) \
+    X(DesktopFile, QString, true) \
+    X(Icon, QString, true) \
+    X(IsActive, bool, true) \
+    X(IsDocked, bool, true) \
+    X(Menu, QString, true) \
+    X(Name, QString, true) \
+    X(WindowInfos, WindowInfoMap, false) \
+    X(Mode, int, true)
+
+template<typename T>
+static T demarshall(const QVariant &value)
+{
+    // 复杂类型(比如WindowInfoMap)在信号中是QDBusArgument，需要按照实际的类型解析
+    if (value.userType() == qMetaTypeId<QDBusArgument>())
+        return qdbus_cast<T>(value.value<QDBusArgument>());
+
+    return qvariant_cast<T>(value);
+}
+
+template<typename T, typename Signal>
+static void updateProperty(Dock_Entry *entry, T &member, const QVariant &value, bool compare, Signal signal)
+{
+    T newValue = demarshall<T>(value);
+    if (compare && member == newValue)
+        return;
+
+    member = std::move(newValue);
+    Q_EMIT (entry->*signal)(member);
+}
+
 class EntryPrivate
 {
 public:
@@ -83,7 +118,7 @@ public:
         : CurrentWindow(0)
         , IsActive(false)
         , IsDocked(false)
-        , mode(0)
+        , Mode(0)
     {}
 
     // begin member variables
@@ -97,7 +132,7 @@ public:
     QString Name;
 
     WindowInfoMap WindowInfos;
-    int mode;
+    int Mode;
 
 public:
     QMap<QString, QDBusPendingCallWatcher *> m_processingCalls;
@@ -105,7 +140,7 @@ public:
 };
 
 Dock_Entry::Dock_Entry(const QString &service, const QString &path, const QDBusConnection &connection, QObject *parent)
-    : QDBusAbstractInterface(service, path, staticInterfaceName(), connection, parent)
+    : DBusTracedInterface(service, path, staticInterfaceName(), connection, parent)
     , d_ptr(new EntryPrivate)
 {
     QDBusConnection::sessionBus().connect(this->service(), this->path(),
@@ -126,91 +161,44 @@ Dock_Entry::~Dock_Entry()
     delete d_ptr;
 }
 
-void Dock_Entry::onPropertyChanged(const QString &propName, const QVariant &value)
+/**
+ * @brief Dock_Entry::onPropertyChanged 后端的PropertiesChanged信号，一次信号中可能包含多个属性的变化
+ */
+void Dock_Entry::onPropertyChanged(const QDBusMessage &msg)
 {
-    if (propName == QStringLiteral("CurrentWindow")) {
-        const uint &CurrentWindow = qvariant_cast<uint>(value);
-        if (d_ptr->CurrentWindow != CurrentWindow) {
-            d_ptr->CurrentWindow = CurrentWindow;
-            Q_EMIT CurrentWindowChanged(d_ptr->CurrentWindow);
-        }
-        return;
-    }
-
-    if (propName == QStringLiteral("DesktopFile")) {
-        const QString &DesktopFile = qvariant_cast<QString>(value);
-        if (d_ptr->DesktopFile != DesktopFile) {
-            d_ptr->DesktopFile = DesktopFile;
-            Q_EMIT DesktopFileChanged(d_ptr->DesktopFile);
-        }
-        return;
-    }
-
-    if (propName == QStringLiteral("Icon")) {
-        const QString &Icon = qvariant_cast<QString>(value);
-        if (d_ptr->Icon != Icon)
-        {
-            d_ptr->Icon = Icon;
-            Q_EMIT IconChanged(d_ptr->Icon);
-        }
+    const QList<QVariant> arguments = msg.arguments();
+    if (arguments.count() != 3 || arguments.at(0).toString() != staticInterfaceName())
         return;
-    }
 
-    if (propName == QStringLiteral("IsActive")) {
-        const bool &IsActive = qvariant_cast<bool>(value);
-        if (d_ptr->IsActive != IsActive) {
-            d_ptr->IsActive = IsActive;
-            Q_EMIT IsActiveChanged(d_ptr->IsActive);
-        }
-        return;
-    }
-
-    if (propName == QStringLiteral("IsDocked")) {
-        const bool &IsDocked = qvariant_cast<bool>(value);
-        if (d_ptr->IsDocked != IsDocked) {
-            d_ptr->IsDocked = IsDocked;
-            Q_EMIT IsDockedChanged(d_ptr->IsDocked);
-        }
-        return;
-    }
+    const QVariantMap changedProps = qdbus_cast<QVariantMap>(arguments.at(1).value<QDBusArgument>());
+    PerformanceTracer *tracer = PerformanceTracer::instance();
+    if (tracer->isEnabled())
+        tracer->markDBusSignal(QString("Entry.%1").arg(changedProps.keys().join(',')));
+    for (auto it = changedProps.constBegin(); it != changedProps.constEnd(); ++it)
+        onPropertyChanged(it.key(), it.value());
+}
 
-    if (propName == QStringLiteral("Menu")) {
-        const QString &Menu = qvariant_cast<QString>(value);
-        if (d_ptr->Menu != Menu) {
-            d_ptr->Menu = Menu;
-            Q_EMIT MenuChanged(d_ptr->Menu);
-        }
-        return;
-    }
+/**
+ * @brief Dock_Entry::onPropertyChanged 按属性名查表分发，每个属性按自己的类型解析、判断是否变化并发出对应的信号
+ * 新增属性时只需要在ENTRY_PROPERTIES中添加一行
+ */
+void Dock_Entry::onPropertyChanged(const QString &propName, const QVariant &value)
+{
+    typedef void (*PropertyHandler)(Dock_Entry *, const QVariant &);
 
-    if (propName == QStringLiteral("Name")) {
-        const QString &Name = qvariant_cast<QString>(value);
-        if (d_ptr->Name != Name) {
-            d_ptr->Name = Name;
-            Q_EMIT NameChanged(d_ptr->Name);
-        }
-        return;
-    }
+#define ENTRY_PROPERTY_HANDLER(Name, Type, Compare) \
+    { QStringLiteral(#Name), [ ](Dock_Entry *entry, const QVariant &value) { \
+        updateProperty<Type>(entry, entry->d_ptr->Name, value, Compare, &Dock_Entry::Name##Changed); } },
 
-    if (propName == QStringLiteral("WindowInfos")) {
-        const WindowInfoMap &WindowInfos = qvariant_cast<WindowInfoMap>(value);
-        if (d_ptr->WindowInfos != WindowInfos) {
-            d_ptr->WindowInfos = WindowInfos;
-            Q_EMIT WindowInfosChanged(d_ptr->WindowInfos);
-        }
-        return;
-    }
+    static const QHash<QString, PropertyHandler> handlers {
+        ENTRY_PROPERTIES(ENTRY_PROPERTY_HANDLER)
+    };
 
-    if (propName == QStringLiteral("Mode")) {
-        const int mode = qvariant_cast<int>(value);
-        if (d_ptr->mode != mode) {
-            d_ptr->mode = mode;
-            Q_EMIT ModeChanged(d_ptr->mode);
-        }
-    }
+#undef ENTRY_PROPERTY_HANDLER
 
-    qWarning() << "property not handle: " << propName;
-    return;
+    const PropertyHandler handler = handlers.value(propName, nullptr);
+    if (handler)
+        handler(this, value);
 }
 
 uint Dock_Entry::currentWindow()
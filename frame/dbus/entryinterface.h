@@ -25,6 +25,8 @@
 #define WINDOWLIST_H
 #define WINDOWINFOLIST_H
 
+#include "dbustracer.h"
+
 #include <QObject>
 #include <QByteArray>
 #include <QList>
@@ -67,7 +69,7 @@ void registerWindowInfoMapMetaType();
  */
 class EntryPrivate;
 
-class Dock_Entry : public QDBusAbstractInterface
+class Dock_Entry : public DBusTracedInterface
 {
     Q_OBJECT
 
@@ -261,6 +263,7 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void onPendingCallFinished(QDBusPendingCallWatcher *w);
+    void onPropertyChanged(const QDBusMessage &msg);
     void onPropertyChanged(const QString &propName, const QVariant &value);
 
 private:
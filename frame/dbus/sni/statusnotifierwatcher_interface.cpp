@@ -16,7 +16,7 @@
  */
 
 StatusNotifierWatcherInterface::StatusNotifierWatcherInterface(const QString &service, const QString &path, const QDBusConnection &connection, QObject *parent)
-    : QDBusAbstractInterface(service, path, staticInterfaceName(), connection, parent)
+    : DBusTracedInterface(service, path, staticInterfaceName(), connection, parent)
 {
 }
 
@@ -11,6 +11,8 @@
 #ifndef STATUSNOTIFIERWATCHERPROXY_H
 #define STATUSNOTIFIERWATCHERPROXY_H
 
+#include "dbustracer.h"
+
 #include <QtCore/QObject>
 #include <QtCore/QByteArray>
 #include <QtCore/QList>
@@ -23,7 +25,7 @@
 /*
  * Proxy class for interface org.kde.StatusNotifierWatcher
  */
-class StatusNotifierWatcherInterface: public QDBusAbstractInterface
+class StatusNotifierWatcherInterface: public DBusTracedInterface
 {
     Q_OBJECT
 public:
@@ -5,7 +5,7 @@
 
 #include "arealist.h"
 
-bool MonitRect::operator ==(const MonitRect &rect)
+bool MonitRect::operator ==(const MonitRect &rect) const
 {
     return x1 == rect.x1 && y1 == rect.y1 && x2 == rect.x2 && y2 == rect.y2;
 }
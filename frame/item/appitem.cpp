@@ -5,10 +5,10 @@
 
 #include "appitem.h"
 #include "themeappicon.h"
-#include "xcb_misc.h"
 #include "appswingeffectbuilder.h"
 #include "utils.h"
 #include "screenspliter.h"
+#include "icongeometrypublisher.h"
 
 #include <X11/X.h>
 #include <X11/Xlib.h>
@@ -48,9 +48,12 @@ AppItem::AppItem(DockInter *dockInter, const QGSettings *appSettings, const QGSe
     , m_iconValid(true)
     , m_lastclickTimes(0)
     , m_appIcon(QPixmap())
-    , m_updateIconGeometryTimer(new QTimer(this))
     , m_retryObtainIconTimer(new QTimer(this))
     , m_refershIconTimer(new QTimer(this))
+    , m_windowInfosTimer(new QTimer(this))
+    , m_allowedCloseWatcher(nullptr)
+    , m_menuReady(false)
+    , m_contextMenuTimer(new QTimer(this))
     , m_themeType(DGuiApplicationHelper::instance()->themeType())
     , m_createMSecs(QDateTime::currentMSecsSinceEpoch())
     , m_screenSpliter(ScreenSpliterFactory::createScreenSpliter(this, m_itemEntryInter))
@@ -63,30 +66,43 @@ AppItem::AppItem(DockInter *dockInter, const QGSettings *appSettings, const QGSe
     setObjectName(m_itemEntryInter->name());
     setAcceptDrops(true);
     setLayout(centralLayout);
+    // 图标、背景和指示器只在状态变化时重新绘制
+    setRenderCacheEnabled(true);
 
     m_id = m_itemEntryInter->id();
     m_active = m_itemEntryInter->isActive();
 
-    m_updateIconGeometryTimer->setInterval(500);
-    m_updateIconGeometryTimer->setSingleShot(true);
-
     m_retryObtainIconTimer->setInterval(3000);
     m_retryObtainIconTimer->setSingleShot(true);
 
     m_refershIconTimer->setInterval(1000);
     m_refershIconTimer->setSingleShot(false);
 
+    // 同一帧内的多次窗口信息变化(比如终端不停地修改标题)合并成一次处理
+    m_windowInfosTimer->setInterval(16);
+    m_windowInfosTimer->setSingleShot(true);
+
+    // 菜单数据变化后在空闲时提前创建好右键菜单
+    m_contextMenuTimer->setInterval(0);
+    m_contextMenuTimer->setSingleShot(true);
+
     connect(m_itemEntryInter, &DockEntryInter::IsActiveChanged, this, &AppItem::activeChanged);
-    connect(m_itemEntryInter, &DockEntryInter::IsActiveChanged, this, static_cast<void (AppItem::*)()>(&AppItem::update));
-    connect(m_itemEntryInter, &DockEntryInter::WindowInfosChanged, this, &AppItem::updateWindowInfos, Qt::QueuedConnection);
+    connect(m_itemEntryInter, &DockEntryInter::IsActiveChanged, this, &AppItem::invalidateRenderCache);
+    connect(m_dockInter, &DockInter::ShowMultiWindowChanged, this, &AppItem::invalidateRenderCache);
+    connect(m_itemEntryInter, &DockEntryInter::WindowInfosChanged, this, &AppItem::onWindowInfosChanged);
+    connect(m_windowInfosTimer, &QTimer::timeout, this, &AppItem::onApplyWindowInfos);
     connect(m_itemEntryInter, &DockEntryInter::IconChanged, this, &AppItem::refreshIcon);
     connect(m_itemEntryInter, &DockEntryInter::ModeChanged, this, &AppItem::modeChanged);
-    connect(m_updateIconGeometryTimer, &QTimer::timeout, this, &AppItem::updateWindowIconGeometries, Qt::QueuedConnection);
+    connect(m_itemEntryInter, &DockEntryInter::MenuChanged, this, &AppItem::onMenuChanged);
+    connect(m_contextMenuTimer, &QTimer::timeout, this, [ this ] {
+        updateContextMenu(m_menuJson);
+    });
     connect(m_retryObtainIconTimer, &QTimer::timeout, this, &AppItem::refreshIcon, Qt::QueuedConnection);
 
     connect(this, &AppItem::requestUpdateEntryGeometries, this, &AppItem::updateWindowIconGeometries);
 
     updateWindowInfos(m_itemEntryInter->windowInfos());
+    requestMenu();
 
     if (m_appSettings)
         connect(m_appSettings, &QGSettings::changed, this, &AppItem::onGSettingsChanged);
@@ -127,23 +143,10 @@ bool AppItem::isValid() const
 // Update _NET_WM_ICON_GEOMETRY property for windows that every item
 // that manages, so that WM can do proper animations for specific
 // window behaviors like minimization.
+// 所有图标的窗口由IconGeometryPublisher统一设置
 void AppItem::updateWindowIconGeometries()
 {
-    // wayland没做处理
-    if (Utils::IS_WAYLAND_DISPLAY)
-        return;
-
-    const QRect r(mapToGlobal(QPoint(0, 0)),
-                  mapToGlobal(QPoint(width(), height())));
-    if (!QX11Info::connection()) {
-        qWarning() << "QX11Info::connection() is 0x0";
-        return;
-    }
-
-    auto *xcb_misc = XcbMisc::instance();
-
-    for (auto it(m_windowInfos.cbegin()); it != m_windowInfos.cend(); ++it)
-        xcb_misc->set_window_icon_geometry(it.key(), r);
+    IconGeometryPublisher::instance()->requestUpdate(this, true);
 }
 
 /**取消驻留在dock上的应用
@@ -244,19 +247,19 @@ void AppItem::moveEvent(QMoveEvent *e)
         m_drag->appDragWidget()->setOriginPos(mapToGlobal(appIconPosition()));
     }
 
-    m_updateIconGeometryTimer->start();
+    IconGeometryPublisher::instance()->requestUpdate(this);
 }
 
 void AppItem::paintEvent(QPaintEvent *e)
 {
-    DockItem::paintEvent(e);
-
     if (isDragging() || (m_swingEffectView != nullptr && DockDisplayMode != Fashion))
         return;
 
-    QPainter painter(this);
-    if (!painter.isActive())
-        return;
+    DockItem::paintEvent(e);
+}
+
+void AppItem::paintRenderCache(QPainter &painter)
+{
     painter.setRenderHint(QPainter::Antialiasing, true);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
 
@@ -398,7 +401,7 @@ void AppItem::mousePressEvent(QMouseEvent *e)
     if (checkGSettingsControl()) {
         return;
     }
-    m_updateIconGeometryTimer->stop();
+    IconGeometryPublisher::instance()->cancelUpdate(this);
     hidePopup();
 
     if (e->button() == Qt::LeftButton)
@@ -527,9 +530,44 @@ void AppItem::invokedMenuItem(const QString &itemId, const bool checked)
 
 const QString AppItem::contextMenu() const
 {
+    // 异步获取的菜单还没有返回的时候才同步读取
+    if (m_menuReady)
+        return m_menuJson;
+
     return m_itemEntryInter->menu();
 }
 
+void AppItem::onMenuChanged(const QString &menu)
+{
+    m_menuJson = menu;
+    m_menuReady = true;
+    m_contextMenuTimer->start();
+}
+
+/**
+ * @brief AppItem::requestMenu 异步获取菜单，右键时不需要再通过DBus读取
+ */
+void AppItem::requestMenu()
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(m_itemEntryInter->service(), m_itemEntryInter->path(),
+                                                          "org.freedesktop.DBus.Properties", "Get");
+    message << QString(DockEntryInter::staticInterfaceName()) << QString("Menu");
+
+    QDBusPendingCall call = DBusTracer::instance()->watch(m_itemEntryInter->connection().asyncCall(message), m_itemEntryInter->service(),
+                                                          DockEntryInter::staticInterfaceName(), "Get(Menu)");
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [ this ](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        QDBusPendingReply<QDBusVariant> reply = *watcher;
+        // 等待返回的过程中收到了MenuChanged，以信号中的为准
+        if (reply.isError() || m_menuReady)
+            return;
+
+        onMenuChanged(reply.value().variant().toString());
+    });
+}
+
 QWidget *AppItem::popupTips()
 {
     if (checkGSettingsControl())
@@ -624,31 +662,105 @@ QPoint AppItem::appIconPosition() const
     return QPoint(iconX, iconY);
 }
 
+void AppItem::onWindowInfosChanged(const WindowInfoMap &info)
+{
+    m_pendingWindowInfos = info;
+    if (!m_windowInfosTimer->isActive())
+        m_windowInfosTimer->start();
+}
+
+void AppItem::onApplyWindowInfos()
+{
+    updateWindowInfos(m_pendingWindowInfos);
+    m_pendingWindowInfos.clear();
+}
+
+/**
+ * @brief AppItem::updateWindowInfos 更新窗口信息
+ * 只有窗口的增减才需要更新图标位置、多开窗口和可关闭的窗口列表，
+ * 只修改了标题的时候只更新打开的预览窗口，提醒状态变化的时候更新提醒效果
+ */
 void AppItem::updateWindowInfos(const WindowInfoMap &info)
 {
+    bool structureChanged = (m_windowInfos.size() != info.size());
+    bool attentionChanged = false;
+    bool titleChanged = false;
+    if (!structureChanged) {
+        for (auto it(m_windowInfos.cbegin()), newIt(info.cbegin()); it != m_windowInfos.cend(); ++it, ++newIt) {
+            if (it.key() != newIt.key()) {
+                structureChanged = true;
+                break;
+            }
+            attentionChanged |= (it.value().attention != newIt.value().attention);
+            titleChanged |= (it.value().title != newIt.value().title || it.value().uuid != newIt.value().uuid);
+        }
+    }
+
+    if (!structureChanged && !attentionChanged && !titleChanged)
+        return;
+
     // 如果是打开第一个窗口，则更新窗口时间
     if (m_windowInfos.isEmpty() && !info.isEmpty())
         updateMSecs();
 
     m_windowInfos = info;
-    if (m_appPreviewTips)
-        m_appPreviewTips->setWindowInfos(m_windowInfos, m_itemEntryInter->GetAllowedCloseWindows().value());
-    m_updateIconGeometryTimer->start();
 
-    // process attention effect
-    if (hasAttention()) {
-        if (DockDisplayMode == DisplayMode::Fashion)
-            playSwingEffect();
-    } else {
-        stopSwingEffect();
+    if (m_appPreviewTips) {
+        m_appPreviewTips->setWindowInfos(m_windowInfos, m_allowedCloseWindows);
+        if (structureChanged)
+            requestAllowedCloseWindows();
     }
 
-    update();
+    if (structureChanged || attentionChanged) {
+        // process attention effect
+        if (hasAttention()) {
+            if (DockDisplayMode == DisplayMode::Fashion)
+                playSwingEffect();
+        } else {
+            stopSwingEffect();
+        }
+
+        invalidateRenderCache();
+    }
+
+    if (!structureChanged)
+        return;
+
+    IconGeometryPublisher::instance()->requestUpdate(this);
 
     // 通知外面窗体数量发生变化，需要更新多开窗口的信息
     Q_EMIT windowCountChanged();
 }
 
+/**
+ * @brief AppItem::requestAllowedCloseWindows 异步获取可以关闭的窗口，返回后更新预览窗口
+ */
+void AppItem::requestAllowedCloseWindows()
+{
+    // 只处理最后一次请求的结果
+    if (m_allowedCloseWatcher)
+        m_allowedCloseWatcher->deleteLater();
+
+    m_allowedCloseWatcher = new QDBusPendingCallWatcher(m_itemEntryInter->GetAllowedCloseWindows(), this);
+    connect(m_allowedCloseWatcher, &QDBusPendingCallWatcher::finished, this, [ this ](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        if (watcher != m_allowedCloseWatcher)
+            return;
+
+        m_allowedCloseWatcher = nullptr;
+
+        QDBusPendingReply<WindowList> reply = *watcher;
+        if (reply.isError()) {
+            qWarning() << "get allowed close windows failed:" << reply.error().message();
+            return;
+        }
+
+        m_allowedCloseWindows = reply.value();
+        if (m_appPreviewTips)
+            m_appPreviewTips->setWindowInfos(m_windowInfos, m_allowedCloseWindows);
+    });
+}
+
 void AppItem::refreshIcon()
 {
     if (!isVisible())
@@ -681,7 +793,7 @@ void AppItem::refreshIcon()
                 QTimer::singleShot(60 * 1000, this, &AppItem::refreshIcon);
         }
 
-        update();
+        invalidateRenderCache();
 
         return;
     }
@@ -691,9 +803,9 @@ void AppItem::refreshIcon()
         m_retryTimes = 0;
     }
 
-    update();
+    invalidateRenderCache();
 
-    m_updateIconGeometryTimer->start();
+    IconGeometryPublisher::instance()->requestUpdate(this);
 }
 
 void AppItem::onRefreshIcon()
@@ -724,7 +836,9 @@ void AppItem::showPreview()
         return;
 
     m_appPreviewTips = new PreviewContainer;
-    m_appPreviewTips->setWindowInfos(m_windowInfos, m_itemEntryInter->GetAllowedCloseWindows().value());
+    // 先使用上一次获取到的可关闭窗口，异步获取返回后再更新
+    m_appPreviewTips->setWindowInfos(m_windowInfos, m_allowedCloseWindows);
+    requestAllowedCloseWindows();
     m_appPreviewTips->updateLayoutDirection(DockPosition);
 
     connect(m_appPreviewTips, &PreviewContainer::requestActivateWindow, this, &AppItem::requestActivateWindow, Qt::QueuedConnection);
@@ -769,11 +883,13 @@ void AppItem::playSwingEffect()
             layout()->removeWidget(m_swingEffectView);
             m_swingEffectView = nullptr;
             m_itemAnimation = nullptr;
+            invalidateRenderCache();
             checkAttentionEffect();
         }
     });
 
     layout()->addWidget(m_swingEffectView);
+    invalidateRenderCache();
     tl->start();
 }
 
@@ -826,13 +942,14 @@ bool AppItem::checkGSettingsControl() const
 void AppItem::onThemeTypeChanged(DGuiApplicationHelper::ColorType themeType)
 {
     m_themeType = themeType;
-    update();
+    invalidateRenderCache();
 }
 
 // 放到最下面是因为析构函数和匿名函数会影响lcov统计单元测试的覆盖率
 AppItem::~AppItem()
 {
     stopSwingEffect();
+    IconGeometryPublisher::instance()->removeItem(this);
 }
 
 void AppItem::showEvent(QShowEvent *e)
@@ -45,6 +45,7 @@ public:
     DockEntryInter *itemEntryInter() const;
     inline ItemType itemType() const override { return App; }
     QPixmap appIcon(){ return m_appIcon; }
+    QPixmap dragPixmap() override { return m_appIcon; }
     virtual QString accessibleName() override;
     void requestDock();
     bool isDocked() const;
@@ -65,6 +66,7 @@ signals:
 private:
     void moveEvent(QMoveEvent *e) override;
     void paintEvent(QPaintEvent *e) override;
+    void paintRenderCache(QPainter &painter) override;
     void mouseReleaseEvent(QMouseEvent *e) override;
     void mousePressEvent(QMouseEvent *e) override;
     void mouseMoveEvent(QMouseEvent *e) override;
@@ -86,7 +88,12 @@ private:
     QPoint appIconPosition() const;
 
 private slots:
+    void onWindowInfosChanged(const WindowInfoMap &info);
+    void onApplyWindowInfos();
     void updateWindowInfos(const WindowInfoMap &info);
+    void requestAllowedCloseWindows();
+    void onMenuChanged(const QString &menu);
+    void requestMenu();
     void refreshIcon() override;
     void activeChanged();
     void showPreview();
@@ -128,9 +135,15 @@ private:
     QPixmap m_activeHorizontalIndicator;
     QPixmap m_activeVerticalIndicator;
 
-    QTimer *m_updateIconGeometryTimer;
     QTimer *m_retryObtainIconTimer;
     QTimer *m_refershIconTimer;         // 当APP为日历时定时（1S）检测是否刷新ICON
+    QTimer *m_windowInfosTimer;         // 合并同一帧内的窗口信息变化
+    WindowInfoMap m_pendingWindowInfos;
+    WindowList m_allowedCloseWindows;   // 最近一次获取到的可以关闭的窗口
+    QDBusPendingCallWatcher *m_allowedCloseWatcher;
+    QString m_menuJson;                 // 缓存的右键菜单数据
+    bool m_menuReady;
+    QTimer *m_contextMenuTimer;
 
     QDate m_curDate;                    // 保存当前icon的日期来判断是否需要更新日历APP的ICON
 
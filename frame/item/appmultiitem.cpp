@@ -29,6 +29,8 @@ AppMultiItem::AppMultiItem(AppItem *appItem, WId winId, const WindowInfo &window
 {
     initMenu();
     initConnection();
+    // 窗口缩略图和应用图标只在窗口激活状态或者图标变化时重新绘制
+    setRenderCacheEnabled(true);
 }
 
 AppMultiItem::~AppMultiItem()
@@ -71,6 +73,7 @@ void AppMultiItem::initMenu()
 void AppMultiItem::initConnection()
 {
     connect(m_entryInter, &DockEntryInter::CurrentWindowChanged, this, &AppMultiItem::onCurrentWindowChanged);
+    connect(m_entryInter, &DockEntryInter::IconChanged, this, &AppMultiItem::invalidateRenderCache);
 }
 
 void AppMultiItem::onOpen()
@@ -80,15 +83,14 @@ void AppMultiItem::onOpen()
 
 void AppMultiItem::onCurrentWindowChanged(uint32_t value)
 {
-    if (value != m_winId)
-        return;
+    Q_UNUSED(value);
 
-    update();
+    // 当前窗口切换到其他窗口时，本窗口的激活背景也需要去掉
+    invalidateRenderCache();
 }
 
-void AppMultiItem::paintEvent(QPaintEvent *)
+void AppMultiItem::paintRenderCache(QPainter &painter)
 {
-    QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing, true);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
 
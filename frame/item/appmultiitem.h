@@ -29,7 +29,7 @@ public:
     ItemType itemType() const override;
 
 protected:
-    void paintEvent(QPaintEvent *) override;
+    void paintRenderCache(QPainter &painter) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
 
 private:
@@ -8,6 +8,7 @@
 #include "../widgets/tipswidget.h"
 #include "utils.h"
 #include "imageutil.h"
+#include "x11atoms.h"
 
 #include <DStyle>
 
@@ -143,9 +144,9 @@ void AppSnapshot::closeWindow() const
         memset(&e, 0, sizeof(e));
         e.xclient.type = ClientMessage;
         e.xclient.window = m_wid;
-        e.xclient.message_type = XInternAtom(display, "WM_PROTOCOLS", true);
+        e.xclient.message_type = X11Atoms::instance()->atom(X11Atoms::WM_PROTOCOLS);
         e.xclient.format = 32;
-        e.xclient.data.l[0] = XInternAtom(display, "WM_DELETE_WINDOW", false);
+        e.xclient.data.l[0] = X11Atoms::instance()->atom(X11Atoms::WM_DELETE_WINDOW);
         e.xclient.data.l[1] = CurrentTime;
 
         Q_EMIT requestCloseAppSnapshot();
@@ -338,7 +339,8 @@ SHMInfo *AppSnapshot::getImageDSHM()
         return nullptr;
     }
 
-    Atom atom_prop = XInternAtom(display, "_DEEPIN_DXCB_SHM_INFO", true);
+    // 只有dxcb的窗口才会创建这个atom，不存在时直接返回
+    const Atom atom_prop = X11Atoms::instance()->atom(QByteArray("_DEEPIN_DXCB_SHM_INFO"));
     if (!atom_prop) {
         return nullptr;
     }
@@ -381,7 +383,7 @@ QRect AppSnapshot::rectRemovedShadow(const QImage &qimage, unsigned char *prop_t
         return QRect();
     }
 
-    const Atom gtk_frame_extents = XInternAtom(display, "_GTK_FRAME_EXTENTS", true);
+    const Atom gtk_frame_extents = X11Atoms::instance()->atom(X11Atoms::GTK_FRAME_EXTENTS);
     Atom actual_type_return_gtk;
     int actual_format_return_gtk;
     unsigned long n_items_return_gtk;
@@ -419,7 +421,7 @@ void AppSnapshot::getWindowState()
         qWarning() << "Error: get display failed!";
         return;
     }
-    Atom atom_prop = XInternAtom(display, "_NET_WM_STATE", true);
+    const Atom atom_prop = X11Atoms::instance()->atom(X11Atoms::NET_WM_STATE);
     if (!atom_prop) {
         return;
     }
@@ -430,11 +432,11 @@ void AppSnapshot::getWindowState()
         return;
     }
 
-    Atom *atoms = reinterpret_cast<Atom *>(properties);
+    // 直接比较atom的值，不用再逐个向X服务器查询名称
+    const Atom hiddenAtom = X11Atoms::instance()->atom(X11Atoms::NET_WM_STATE_HIDDEN);
+    const Atom *atoms = reinterpret_cast<const Atom *>(properties);
     for (i = 0; i < num_items; ++i) {
-        const char *atomName = XGetAtomName(display, atoms[i]);
-
-        if (strcmp(atomName, "_NET_WM_STATE_HIDDEN") == 0) {
+        if (atoms[i] == hiddenAtom) {
             m_isWidowHidden = true;
             break;
         }
@@ -12,6 +12,11 @@
 #include <QCursor>
 #include <QApplication>
 #include <QMenu>
+#include <QPainter>
+
+#include <DGuiApplicationHelper>
+
+DGUI_USE_NAMESPACE
 
 #define PLUGIN_MARGIN  10
 #define ITEM_MAXSIZE    100
@@ -29,6 +34,11 @@ DockItem::DockItem(QWidget *parent)
     , m_contextMenu(new QMenu(this))
     , m_popupTipsDelayTimer(new QTimer(this))
     , m_popupAdjustDelayTimer(new QTimer(this))
+    , m_renderCacheEnabled(false)
+    , m_renderCacheValid(false)
+    , m_renderCacheTheme(-1)
+    , m_renderCachePosition(DockPosition)
+    , m_renderCacheDisplayMode(DockDisplayMode)
 {
     if (PopupWindow.isNull()) {
         DockPopupWindow *arrowRectangle = new DockPopupWindow(nullptr);
@@ -139,7 +149,72 @@ void DockItem::updatePopupPosition()
 
 void DockItem::paintEvent(QPaintEvent *e)
 {
-    QWidget::paintEvent(e);
+    if (!m_renderCacheEnabled || rect().isEmpty())
+        return QWidget::paintEvent(e);
+
+    updateRenderCache();
+
+    QPainter painter(this);
+    painter.drawPixmap(0, 0, m_renderCache);
+}
+
+void DockItem::updateRenderCache()
+{
+    const qreal ratio = devicePixelRatioF();
+    const int themeType = DGuiApplicationHelper::instance()->themeType();
+    if (m_renderCacheValid
+            && m_renderCache.size() == size() * ratio
+            && qFuzzyCompare(m_renderCache.devicePixelRatioF(), ratio)
+            && m_renderCacheTheme == themeType
+            && m_renderCachePosition == DockPosition
+            && m_renderCacheDisplayMode == DockDisplayMode)
+        return;
+
+    m_renderCache = QPixmap(size() * ratio);
+    m_renderCache.setDevicePixelRatio(ratio);
+    m_renderCache.fill(Qt::transparent);
+
+    QPainter cachePainter(&m_renderCache);
+    paintRenderCache(cachePainter);
+
+    m_renderCacheValid = true;
+    m_renderCacheTheme = themeType;
+    m_renderCachePosition = DockPosition;
+    m_renderCacheDisplayMode = DockDisplayMode;
+}
+
+/**
+ * @brief DockItem::dragPixmap 拖拽时显示的图片
+ * 开启了绘制缓存时直接使用缓存的图片，不需要在拖拽开始的时候再把整个控件重新绘制一遍
+ */
+QPixmap DockItem::dragPixmap()
+{
+    if (!m_renderCacheEnabled || rect().isEmpty())
+        return grab();
+
+    updateRenderCache();
+    return m_renderCache;
+}
+
+void DockItem::setRenderCacheEnabled(bool enabled)
+{
+    if (m_renderCacheEnabled == enabled)
+        return;
+
+    m_renderCacheEnabled = enabled;
+    m_renderCache = QPixmap();
+    invalidateRenderCache();
+}
+
+void DockItem::invalidateRenderCache()
+{
+    m_renderCacheValid = false;
+    update();
+}
+
+void DockItem::paintRenderCache(QPainter &painter)
+{
+    Q_UNUSED(painter);
 }
 
 void DockItem::mousePressEvent(QMouseEvent *e)
@@ -214,39 +289,65 @@ const QRect DockItem::perfectIconRect() const
 
 void DockItem::showContextMenu()
 {
-    const QString menuJson = contextMenu();
-    if (menuJson.isEmpty())
+    if (!updateContextMenu(contextMenu()))
         return;
 
-    QJsonDocument jsonDocument = QJsonDocument::fromJson(menuJson.toLocal8Bit().data());
-    if (jsonDocument.isNull())
-        return;
+    hidePopup();
+    emit requestWindowAutoHide(false);
+
+    m_contextMenu->exec(QCursor::pos());
+
+    onContextMenuAccepted();
+}
 
-    QJsonObject jsonMenu = jsonDocument.object();
+/**
+ * @brief DockItem::updateContextMenu 根据菜单的json更新右键菜单
+ * 和上一次的json相同时直接使用已经创建好的菜单，不同时只修改有变化的菜单项，多出的菜单项删除，不够的再创建，
+ * 子类可以在菜单数据变化的时候提前调用，右键时就不需要再解析和创建菜单
+ * @return 菜单为空或者json解析失败返回false
+ */
+bool DockItem::updateContextMenu(const QString &menuJson)
+{
+    if (menuJson.isEmpty())
+        return false;
+
+    if (menuJson == m_contextMenuJson)
+        return true;
 
-    qDeleteAll(m_contextMenu->actions());
+    QJsonDocument jsonDocument = QJsonDocument::fromJson(menuJson.toLocal8Bit().data());
+    if (jsonDocument.isNull())
+        return false;
+
+    const QJsonArray jsonMenuItems = jsonDocument.object().value("items").toArray();
+    const QList<QAction *> actions = m_contextMenu->actions();
+    for (int i = 0; i < jsonMenuItems.size(); ++i) {
+        QJsonObject itemObj = jsonMenuItems.at(i).toObject();
+        QAction *action = actions.value(i, nullptr);
+        if (!action) {
+            action = new QAction(m_contextMenu);
+            m_contextMenu->addAction(action);
+        }
 
-    QJsonArray jsonMenuItems = jsonMenu.value("items").toArray();
-    for (auto item : jsonMenuItems) {
-        QJsonObject itemObj = item.toObject();
-        QAction *action = new QAction(itemObj.value("itemText").toString());
+        action->setText(itemObj.value("itemText").toString());
         action->setCheckable(itemObj.value("isCheckable").toBool());
         action->setChecked(itemObj.value("checked").toBool());
         action->setData(itemObj.value("itemId").toString());
         action->setEnabled(itemObj.value("isActive").toBool());
-        m_contextMenu->addAction(action);
     }
 
-    hidePopup();
-    emit requestWindowAutoHide(false);
-
-    m_contextMenu->exec(QCursor::pos());
+    for (int i = jsonMenuItems.size(); i < actions.size(); ++i)
+        delete actions.at(i);
 
-    onContextMenuAccepted();
+    m_contextMenuJson = menuJson;
+    return true;
 }
 
 void DockItem::menuActionClicked(QAction *action)
 {
+    // 点击可选中的菜单项时QMenu已经改变了它的选中状态，清空缓存的json，下次显示菜单时按照新的json重新设置
+    if (action->isCheckable())
+        m_contextMenuJson.clear();
+
     invokedMenuItem(action->data().toString(), true);
 }
 
@@ -11,6 +11,7 @@
 
 #include <QFrame>
 #include <QPointer>
+#include <QPixmap>
 #include <QGestureEvent>
 
 #include <memory>
@@ -18,6 +19,7 @@
 using namespace Dock;
 
 class QMenu;
+class QPainter;
 
 class DockItem : public QWidget
 {
@@ -47,6 +49,7 @@ public:
 
     QSize sizeHint() const override;
     virtual QString accessibleName();
+    virtual QPixmap dragPixmap();
 
 public slots:
     virtual void refreshIcon() {}
@@ -80,11 +83,21 @@ protected:
     virtual void showHoverTips();
     virtual void invokedMenuItem(const QString &itemId, const bool checked);
     virtual const QString contextMenu() const;
+    bool updateContextMenu(const QString &menuJson);
     virtual QWidget *popupTips();
 
     bool checkAndResetTapHoldGestureState();
     virtual void gestureEvent(QGestureEvent *event);
 
+    // 静态内容的绘制缓存，开启后paintEvent只绘制缓存的图片，缓存在尺寸、主题、缩放比例、
+    // 任务栏位置和模式变化，或者调用invalidateRenderCache后才在paintRenderCache中重新绘制
+    void setRenderCacheEnabled(bool enabled);
+    void invalidateRenderCache();
+    virtual void paintRenderCache(QPainter &painter);
+
+private:
+    void updateRenderCache();
+
 protected slots:
     void showContextMenu();
     void onContextMenuAccepted();
@@ -99,12 +112,20 @@ protected:
     bool m_tapAndHold;
     bool m_draging;
     QMenu *m_contextMenu;
+    QString m_contextMenuJson;          // 当前右键菜单对应的json
 
     QPointer<QWidget> m_lastPopupWidget;
 
     QTimer *m_popupTipsDelayTimer;
     QTimer *m_popupAdjustDelayTimer;
 
+    bool m_renderCacheEnabled;
+    bool m_renderCacheValid;
+    QPixmap m_renderCache;
+    int m_renderCacheTheme;
+    Position m_renderCachePosition;
+    DisplayMode m_renderCacheDisplayMode;
+
     static Position DockPosition;
     static DisplayMode DockDisplayMode;
     static QPointer<DockPopupWindow> PopupWindow;
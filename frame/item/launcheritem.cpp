@@ -25,6 +25,8 @@ LauncherItem::LauncherItem(QWidget *parent)
     : DockItem(parent)
     , m_gsettings(Utils::ModuleSettingsPtr("launcher", QByteArray(), this))
 {
+    setRenderCacheEnabled(true);
+
     if (m_gsettings) {
         connect(m_gsettings, &QGSettings::changed, this, &LauncherItem::onGSettingsChanged);
     }
@@ -39,18 +41,11 @@ void LauncherItem::refreshIcon()
         ThemeAppIcon::getIcon(m_icon, "deepin-launcher", iconSize * 0.8);
     }
 
-    update();
+    invalidateRenderCache();
 }
 
-void LauncherItem::paintEvent(QPaintEvent *e)
+void LauncherItem::paintRenderCache(QPainter &painter)
 {
-    DockItem::paintEvent(e);
-
-    if (!isVisible())
-        return;
-
-    QPainter painter(this);
-
     const auto ratio = devicePixelRatioF();
     const int iconX = rect().center().x() - m_icon.rect().center().x() / ratio;
     const int iconY = rect().center().y() - m_icon.rect().center().y() / ratio;
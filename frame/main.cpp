@@ -12,6 +12,7 @@
 #include "dockapplication.h"
 #include "traymainwindow.h"
 #include "windowmanager.h"
+#include "x11atoms.h"
 
 #include <QAccessible>
 #include <QDir>
@@ -211,6 +212,9 @@ int main(int argc, char *argv[])
     bool disablePlugin = parser.isSet(disablePlugOption);
     qApp->setProperty("safeMode", (isSafeMode || disablePlugin));
 
+    // 启动时一次性获取常用的X11 atom
+    X11Atoms::instance();
+
     MultiScreenWorker multiScreenWorker;
 
     MainWindow mainWindow(&multiScreenWorker);
@@ -0,0 +1,174 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "clockscheduler.h"
+
+#include <QTimer>
+#include <QSocketNotifier>
+#include <QDebug>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+SystemClockSource::SystemClockSource(QObject *parent)
+    : ClockSource(parent)
+    , m_timerFd(timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC))
+    , m_notifier(nullptr)
+    , m_fallbackTimer(new QTimer(this))
+{
+    m_fallbackTimer->setSingleShot(true);
+    m_fallbackTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_fallbackTimer, &QTimer::timeout, this, &SystemClockSource::timeout);
+
+    if (m_timerFd < 0) {
+        qWarning() << "create timerfd failed, system clock changes will not be noticed:" << strerror(errno);
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_timerFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &SystemClockSource::onTimerActivated);
+}
+
+SystemClockSource::~SystemClockSource()
+{
+    if (m_timerFd >= 0)
+        ::close(m_timerFd);
+}
+
+QDateTime SystemClockSource::currentDateTime() const
+{
+    return QDateTime::currentDateTime();
+}
+
+void SystemClockSource::wakeAt(const QDateTime &deadline)
+{
+    if (m_timerFd >= 0) {
+        const qint64 msecs = deadline.toMSecsSinceEpoch();
+        struct itimerspec spec = {};
+        spec.it_value.tv_sec = static_cast<time_t>(msecs / 1000);
+        spec.it_value.tv_nsec = static_cast<long>((msecs % 1000) * 1000000);
+        // 使用墙上时间的绝对时间唤醒，休眠唤醒后也能按时触发，系统时间被修改的时候read会返回ECANCELED
+        if (timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) == 0)
+            return;
+
+        qWarning() << "set timerfd failed:" << strerror(errno);
+    }
+
+    m_fallbackTimer->start(static_cast<int>(qMax<qint64>(0, currentDateTime().msecsTo(deadline))));
+}
+
+void SystemClockSource::cancel()
+{
+    m_fallbackTimer->stop();
+
+    if (m_timerFd >= 0) {
+        struct itimerspec spec = {};
+        timerfd_settime(m_timerFd, 0, &spec, nullptr);
+    }
+}
+
+void SystemClockSource::onTimerActivated()
+{
+    quint64 expirations = 0;
+    const ssize_t size = ::read(m_timerFd, &expirations, sizeof(expirations));
+    if (size < 0 && errno == ECANCELED) {
+        Q_EMIT clockChanged();
+        return;
+    }
+
+    if (size == sizeof(expirations))
+        Q_EMIT timeout();
+}
+
+ClockScheduler::ClockScheduler(ClockSource *source, QObject *parent)
+    : QObject(parent)
+    , m_source(source ? source : new SystemClockSource(this))
+    , m_resolution(Minute)
+    , m_active(false)
+    , m_wakeupCount(0)
+{
+    if (!m_source->parent())
+        m_source->setParent(this);
+
+    connect(m_source, &ClockSource::timeout, this, &ClockScheduler::onTimeout);
+    connect(m_source, &ClockSource::clockChanged, this, &ClockScheduler::onClockChanged);
+}
+
+void ClockScheduler::start()
+{
+    if (m_active)
+        return;
+
+    m_active = true;
+    scheduleNext();
+}
+
+void ClockScheduler::stop()
+{
+    if (!m_active)
+        return;
+
+    m_active = false;
+    m_deadline = QDateTime();
+    m_source->cancel();
+}
+
+void ClockScheduler::setResolution(Resolution resolution)
+{
+    if (m_resolution == resolution)
+        return;
+
+    m_resolution = resolution;
+    if (m_active)
+        scheduleNext();
+}
+
+/**
+ * @brief ClockScheduler::nextBoundary 下一个整分钟或者整秒的时间
+ * 时区的偏移都是整分钟，按照UTC对齐的整分钟也是本地时间的整分钟
+ */
+QDateTime ClockScheduler::nextBoundary(const QDateTime &current, Resolution resolution)
+{
+    const qint64 unit = (resolution == Second ? 1000 : 60 * 1000);
+    const qint64 msecs = current.toMSecsSinceEpoch();
+    return QDateTime::fromMSecsSinceEpoch((msecs / unit + 1) * unit, current.timeSpec());
+}
+
+void ClockScheduler::onTimeout()
+{
+    m_wakeupCount++;
+
+    if (!m_active)
+        return;
+
+    // 提前唤醒的时候还没有到显示的内容变化的时间，继续等待
+    if (m_source->currentDateTime() < m_deadline) {
+        m_source->wakeAt(m_deadline);
+        return;
+    }
+
+    Q_EMIT tick();
+    scheduleNext();
+}
+
+void ClockScheduler::onClockChanged()
+{
+    m_wakeupCount++;
+
+    if (!m_active)
+        return;
+
+    // 时间跳变后立即刷新，并按照新的时间重新对齐
+    Q_EMIT tick();
+    scheduleNext();
+}
+
+void ClockScheduler::scheduleNext()
+{
+    m_deadline = nextBoundary(m_source->currentDateTime(), m_resolution);
+    m_source->wakeAt(m_deadline);
+}
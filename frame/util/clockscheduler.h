@@ -0,0 +1,103 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef CLOCKSCHEDULER_H
+#define CLOCKSCHEDULER_H
+
+#include <QObject>
+#include <QDateTime>
+
+class QTimer;
+class QSocketNotifier;
+
+/** 时钟的来源，提供当前时间和在指定时间唤醒的能力，测试中可以替换成可控制的时钟
+ * @brief The ClockSource class
+ */
+class ClockSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ClockSource(QObject *parent = nullptr) : QObject(parent) {}
+
+    virtual QDateTime currentDateTime() const = 0;
+    virtual void wakeAt(const QDateTime &deadline) = 0;     // 在指定的时间唤醒，只保留最后一次设置的时间
+    virtual void cancel() = 0;
+
+Q_SIGNALS:
+    void timeout();
+    void clockChanged();                                    // 系统时间发生了跳变(手动修改、NTP同步、休眠唤醒)
+};
+
+/** 系统时钟，使用CLOCK_REALTIME的timerfd在指定的墙上时间唤醒，系统时间被修改时会收到通知
+ * @brief The SystemClockSource class
+ */
+class SystemClockSource : public ClockSource
+{
+    Q_OBJECT
+
+public:
+    explicit SystemClockSource(QObject *parent = nullptr);
+    ~SystemClockSource() override;
+
+    QDateTime currentDateTime() const override;
+    void wakeAt(const QDateTime &deadline) override;
+    void cancel() override;
+
+private Q_SLOTS:
+    void onTimerActivated();
+
+private:
+    int m_timerFd;
+    QSocketNotifier *m_notifier;
+    QTimer *m_fallbackTimer;                                // timerfd不可用的时候使用，无法感知系统时间的修改
+};
+
+/** 按照显示的时间单位对齐唤醒的定时器
+ * @brief The ClockScheduler class
+ * 只在显示的内容发生变化的时候(整分钟或者整秒)唤醒一次，系统时间跳变后立即刷新并重新对齐
+ */
+class ClockScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Resolution {
+        Minute,
+        Second
+    };
+
+    explicit ClockScheduler(ClockSource *source = nullptr, QObject *parent = nullptr);
+
+    void start();
+    void stop();
+    bool isActive() const { return m_active; }
+
+    void setResolution(Resolution resolution);
+    Resolution resolution() const { return m_resolution; }
+
+    quint64 wakeupCount() const { return m_wakeupCount; }
+
+    static QDateTime nextBoundary(const QDateTime &current, Resolution resolution);
+
+Q_SIGNALS:
+    void tick();
+
+private Q_SLOTS:
+    void onTimeout();
+    void onClockChanged();
+
+private:
+    void scheduleNext();
+
+private:
+    ClockSource *m_source;
+    Resolution m_resolution;
+    bool m_active;
+    QDateTime m_deadline;
+    quint64 m_wakeupCount;
+};
+
+#endif // CLOCKSCHEDULER_H
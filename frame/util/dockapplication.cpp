@@ -4,6 +4,7 @@
 
 #include "dockapplication.h"
 #include "constants.h"
+#include "performancetracer.h"
 
 #include <QMouseEvent>
 #include <QTouchEvent>
@@ -11,6 +12,8 @@
 DockApplication::DockApplication(int &argc, char **argv)
     : DApplication (argc, argv)
 {
+    // 根据环境变量决定是否打开性能追踪
+    PerformanceTracer::instance();
 }
 
 bool DockApplication::notify(QObject *obj, QEvent *event)
@@ -33,5 +36,26 @@ bool DockApplication::notify(QObject *obj, QEvent *event)
         return true;
     }
 
-    return DApplication::notify(obj, event);
+    PerformanceTracer *tracer = PerformanceTracer::instance();
+    if (!tracer->isEnabled())
+        return DApplication::notify(obj, event);
+
+    // 只记录重绘和窗口系统产生的输入事件，接收者在处理过程中可能被删除，需要提前记录名称
+    const QEvent::Type type = event->type();
+    QInputEvent *inputEvent = event->spontaneous() ? dynamic_cast<QInputEvent *>(event) : nullptr;
+    if (!inputEvent && !(type == QEvent::Paint && obj->isWidgetType()))
+        return DApplication::notify(obj, event);
+
+    const QString receiver = PerformanceTracer::describe(obj);
+    const ulong timestamp = inputEvent ? inputEvent->timestamp() : 0;
+    const qint64 start = tracer->now();
+    const bool result = DApplication::notify(obj, event);
+    const qint64 duration = tracer->now() - start;
+
+    if (inputEvent)
+        tracer->recordInput(receiver, type, timestamp, start, duration);
+    else
+        tracer->recordPaint(receiver, start, duration);
+
+    return result;
 }
@@ -0,0 +1,116 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "icongeometrypublisher.h"
+#include "appitem.h"
+#include "xcb_misc.h"
+#include "utils.h"
+
+#include <QTimer>
+#include <QX11Info>
+
+#include <xcb/xcb.h>
+
+#define ICON_GEOMETRY_DELAY 500         // 图标位置稳定这么长时间后才设置
+
+IconGeometryPublisher::IconGeometryPublisher(QObject *parent)
+    : QObject(parent)
+    , m_publishTimer(new QTimer(this))
+    , m_suspended(false)
+{
+    m_publishTimer->setSingleShot(true);
+    connect(m_publishTimer, &QTimer::timeout, this, &IconGeometryPublisher::publish);
+}
+
+/**
+ * @brief IconGeometryPublisher::requestUpdate 图标的位置或者窗口发生了变化
+ * @param immediately 为true时在下一次事件循环中设置，否则等所有图标的位置稳定之后再设置
+ */
+void IconGeometryPublisher::requestUpdate(AppItem *item, bool immediately)
+{
+    m_pendingItems.insert(item);
+
+    if (m_suspended)
+        return;
+
+    if (immediately)
+        m_publishTimer->start(0);
+    else if (!m_publishTimer->isActive() || m_publishTimer->interval() != 0)
+        m_publishTimer->start(ICON_GEOMETRY_DELAY);
+}
+
+void IconGeometryPublisher::cancelUpdate(AppItem *item)
+{
+    m_pendingItems.remove(item);
+}
+
+void IconGeometryPublisher::removeItem(AppItem *item)
+{
+    m_pendingItems.remove(item);
+    for (quint32 xid : m_itemWindows.take(item))
+        m_publishedGeometry.remove(xid);
+}
+
+/**
+ * @brief IconGeometryPublisher::setSuspended 任务栏显示隐藏的动画开始时暂停，结束后把暂停期间的变化一起设置
+ */
+void IconGeometryPublisher::setSuspended(bool suspended)
+{
+    if (m_suspended == suspended)
+        return;
+
+    m_suspended = suspended;
+    if (m_suspended)
+        m_publishTimer->stop();
+    else if (!m_pendingItems.isEmpty())
+        m_publishTimer->start(0);
+}
+
+void IconGeometryPublisher::publish()
+{
+    if (m_suspended || m_pendingItems.isEmpty())
+        return;
+
+    // wayland没做处理
+    if (Utils::IS_WAYLAND_DISPLAY) {
+        m_pendingItems.clear();
+        return;
+    }
+
+    xcb_connection_t *connection = QX11Info::connection();
+    if (!connection) {
+        qWarning() << "QX11Info::connection() is 0x0";
+        return;
+    }
+
+    XcbMisc *xcbMisc = XcbMisc::instance();
+    int changedCount = 0;
+    for (AppItem *item : m_pendingItems) {
+        const QRect rect(item->mapToGlobal(QPoint(0, 0)),
+                         item->mapToGlobal(QPoint(item->width(), item->height())));
+        const QList<quint32> windows = item->windowsMap().keys();
+
+        // 已经关闭或者不属于这个图标的窗口不再记录
+        for (quint32 xid : m_itemWindows.value(item)) {
+            if (!windows.contains(xid))
+                m_publishedGeometry.remove(xid);
+        }
+        m_itemWindows[item] = windows;
+
+        for (quint32 xid : windows) {
+            auto it = m_publishedGeometry.find(xid);
+            if (it != m_publishedGeometry.end() && it.value() == rect)
+                continue;
+
+            xcbMisc->set_window_icon_geometry(xid, rect);
+            m_publishedGeometry[xid] = rect;
+            changedCount++;
+        }
+    }
+    m_pendingItems.clear();
+
+    if (changedCount > 0)
+        xcb_flush(connection);
+}
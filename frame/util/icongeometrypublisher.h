@@ -0,0 +1,52 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef ICONGEOMETRYPUBLISHER_H
+#define ICONGEOMETRYPUBLISHER_H
+
+#include "singleton.h"
+
+#include <QObject>
+#include <QHash>
+#include <QRect>
+#include <QSet>
+
+class AppItem;
+class QTimer;
+
+/** 统一设置应用窗口的_NET_WM_ICON_GEOMETRY属性
+ * @brief The IconGeometryPublisher class
+ * 应用图标的位置或者窗口变化后只记录下来，等所有图标的位置稳定后一起计算，
+ * 只设置和上一次不同的窗口属性，最后只flush一次；任务栏显示隐藏的动画过程中不设置
+ */
+class IconGeometryPublisher : public QObject, public Singleton<IconGeometryPublisher>
+{
+    Q_OBJECT
+
+    friend class Singleton<IconGeometryPublisher>;
+
+public:
+    void requestUpdate(AppItem *item, bool immediately = false);
+    void cancelUpdate(AppItem *item);
+    void removeItem(AppItem *item);
+
+    void setSuspended(bool suspended);
+    bool isSuspended() const { return m_suspended; }
+
+private Q_SLOTS:
+    void publish();
+
+private:
+    explicit IconGeometryPublisher(QObject *parent = nullptr);
+
+private:
+    QTimer *m_publishTimer;
+    bool m_suspended;
+    QSet<AppItem *> m_pendingItems;
+    QHash<AppItem *, QList<quint32>> m_itemWindows;     // 每个图标上一次设置过的窗口
+    QHash<quint32, QRect> m_publishedGeometry;          // 每个窗口上一次设置的位置
+};
+
+#endif // ICONGEOMETRYPUBLISHER_H
@@ -13,6 +13,8 @@
 #include "windowmanager.h"
 #include "dockitemmanager.h"
 #include "dockscreen.h"
+#include "pointeredgemonitor.h"
+#include "icongeometrypublisher.h"
 
 #include <QWidget>
 #include <QScreen>
@@ -42,6 +44,7 @@ MultiScreenWorker::MultiScreenWorker(QObject *parent)
     , m_eventInter(new XEventMonitor(xEventMonitorService, xEventMonitorPath, QDBusConnection::sessionBus(), this))
     , m_extralEventInter(new XEventMonitor(xEventMonitorService, xEventMonitorPath, QDBusConnection::sessionBus(), this))
     , m_touchEventInter(new XEventMonitor(xEventMonitorService, xEventMonitorPath, QDBusConnection::sessionBus(), this))
+    , m_edgeMonitor(new PointerEdgeMonitor(this))
     , m_dockInter(new DockInter(dockServiceName(), dockServicePath(), QDBusConnection::sessionBus(), this))
     , m_launcherInter(new DBusLuncher(launcherService, launcherPath, QDBusConnection::sessionBus(), this))
     , m_appearanceInter(new Appearance("org.deepin.dde.Appearance1", "/org/deepin/dde/Appearance1", QDBusConnection::sessionBus(), this))
@@ -85,6 +88,9 @@ void MultiScreenWorker::setStates(RunStates state, bool on)
         m_state |= type;
     else
         m_state &= ~(type);
+
+    // 动画过程中图标的位置一直在变化，不设置窗口的图标位置
+    IconGeometryPublisher::instance()->setSuspended(m_state & (ShowAnimationStart | HideAnimationStart | ChangePositionAnimationStart));
 }
 
 void MultiScreenWorker::onAutoHideChanged(const bool autoHide)
@@ -105,15 +111,35 @@ void MultiScreenWorker::onRegionMonitorChanged(int x, int y, const QString &key)
     tryToShowDock(x, y);
 }
 
-// 鼠标在任务栏之外移动时,任务栏该响应隐藏时需要隐藏
 void MultiScreenWorker::onExtralRegionMonitorChanged(int x, int y, const QString &key)
 {
-    // TODO 后续可以考虑去掉这部分的处理，不用一直监听外部区域的移动，xeventmonitor有一个CursorInto和CursorOut的信号，使用这个也可以替代，但要做好测试工作
-    Q_UNUSED(x);
-    Q_UNUSED(y);
-    Q_UNUSED(key);
+    if (m_extralRegisterKey != key)
+        return;
+
+    onCursorOut(x, y);
+}
+
+/**
+ * @brief MultiScreenWorker::onCursorOut 鼠标离开任务栏区域
+ * XEventMonitor服务和进程内的PointerEdgeMonitor共用这部分处理
+ */
+void MultiScreenWorker::onCursorOut(int x, int y)
+{
+    if (!isCursorOut(x, y))
+        return;
+
+    if (testState(ShowAnimationStart)) {
+        // 在OUT后如果检测到当前的动画正在进行，在out后延迟500毫秒等动画结束再执行移出动画
+        QTimer::singleShot(500, this, &MultiScreenWorker::leaveDockArea);
+    } else {
+        leaveDockArea();
+    }
+}
 
-    if (m_extralRegisterKey != key || testState(MousePress))
+// 鼠标移动到任务栏之外时,任务栏该响应隐藏时需要隐藏
+void MultiScreenWorker::leaveDockArea()
+{
+    if (testState(MousePress))
         return;
 
     // FIXME:每次都要重置一下，是因为qt中的QScreen类缺少nameChanged信号，后面会给上游提交patch修复
@@ -279,38 +305,13 @@ void MultiScreenWorker::onOpacityChanged(const double value)
  */
 void MultiScreenWorker::onRequestUpdateRegionMonitor()
 {
-    if (!m_registerKey.isEmpty()) {
-#ifdef QT_DEBUG
-        bool ret = m_eventInter->UnregisterArea(m_registerKey);
-        qDebug() << "取消唤起区域监听:" << ret;
-#else
-        m_eventInter->UnregisterArea(m_registerKey);
-#endif
-        m_registerKey.clear();
-    }
-
-    if (!m_extralRegisterKey.isEmpty()) {
-#ifdef QT_DEBUG
-        bool ret = m_extralEventInter->UnregisterArea(m_extralRegisterKey);
-        qDebug() << "取消任务栏外部区域监听:" << ret;
-#else
-        m_extralEventInter->UnregisterArea(m_extralRegisterKey);
-#endif
-        m_extralRegisterKey.clear();
-    }
-
-    if (!m_touchRegisterKey.isEmpty()) {
-        m_touchEventInter->UnregisterArea(m_touchRegisterKey);
-        m_touchRegisterKey.clear();
-    }
-
     const static int flags = Motion | Button | Key;
     const static int monitorHeight = static_cast<int>(15 * qApp->devicePixelRatio());
     // 后端认为的任务栏大小(无缩放因素影响)
     const int realDockSize = int((m_displayMode == DisplayMode::Fashion ? m_dockInter->windowSizeFashion() + 2 * 10 /*上下的边距各10像素*/ : m_dockInter->windowSizeEfficient()) * qApp->devicePixelRatio());
 
     // 任务栏唤起区域
-    m_monitorRectList.clear();
+    QList<MonitRect> monitorRectList;
     for (auto s : DIS_INS->screens()) {
         // 屏幕此位置不可停靠时,不用监听这块区域
         if (!DIS_INS->canDock(s, m_position))
@@ -351,15 +352,15 @@ void MultiScreenWorker::onRequestUpdateRegionMonitor()
             break;
         }
 
-        if (!m_monitorRectList.contains(monitorRect)) {
-            m_monitorRectList << monitorRect;
+        if (!monitorRectList.contains(monitorRect)) {
+            monitorRectList << monitorRect;
 #ifdef QT_DEBUG
             qDebug() << "监听区域：" << monitorRect.x1 << monitorRect.y1 << monitorRect.x2 << monitorRect.y2;
 #endif
         }
     }
 
-    m_extralRectList.clear();
+    QList<MonitRect> extralRectList;
     for (auto s : DIS_INS->screens()) {
         // 屏幕此位置不可停靠时,不用监听这块区域
         if (!DIS_INS->canDock(s, m_position))
@@ -400,8 +401,8 @@ void MultiScreenWorker::onRequestUpdateRegionMonitor()
             break;
         }
 
-        if (!m_extralRectList.contains(monitorRect)) {
-            m_extralRectList << monitorRect;
+        if (!extralRectList.contains(monitorRect)) {
+            extralRectList << monitorRect;
 #ifdef QT_DEBUG
             qDebug() << "任务栏内部区域：" << monitorRect.x1 << monitorRect.y1 << monitorRect.x2 << monitorRect.y2;
 #endif
@@ -412,7 +413,7 @@ void MultiScreenWorker::onRequestUpdateRegionMonitor()
     const int monitHeight = 100 + WINDOWMARGIN;
 
     // 任务栏触屏唤起区域
-    m_touchRectList.clear();
+    QList<MonitRect> touchRectList;
     for (auto s : DIS_INS->screens()) {
         // 屏幕此位置不可停靠时,不用监听这块区域
         if (!DIS_INS->canDock(s, m_position))
@@ -453,15 +454,54 @@ void MultiScreenWorker::onRequestUpdateRegionMonitor()
             break;
         }
 
-        if (!m_touchRectList.contains(monitorRect)) {
-            m_touchRectList << monitorRect;
+        if (!touchRectList.contains(monitorRect)) {
+            touchRectList << monitorRect;
         }
 
     }
 
-    m_registerKey = m_eventInter->RegisterAreas(m_monitorRectList, flags);
-    m_extralRegisterKey = m_extralEventInter->RegisterAreas(m_extralRectList, flags);
-    m_touchRegisterKey = m_touchEventInter->RegisterAreas(m_touchRectList, flags);
+    // 拖拽区域的定时器也会触发这里，区域没有变化时不需要重新注册
+    if (m_edgeMonitor->isActive()) {
+        m_edgeMonitor->setEdgeAreas(monitorRectList);
+        m_edgeMonitor->setDockAreas(extralRectList);
+        m_monitorRectList = monitorRectList;
+        m_extralRectList = extralRectList;
+    } else {
+        if (m_registerKey.isEmpty() || monitorRectList != m_monitorRectList) {
+            if (!m_registerKey.isEmpty()) {
+#ifdef QT_DEBUG
+                bool ret = m_eventInter->UnregisterArea(m_registerKey);
+                qDebug() << "取消唤起区域监听:" << ret;
+#else
+                m_eventInter->UnregisterArea(m_registerKey);
+#endif
+            }
+            m_monitorRectList = monitorRectList;
+            m_registerKey = m_eventInter->RegisterAreas(m_monitorRectList, flags);
+        }
+
+        if (m_extralRegisterKey.isEmpty() || extralRectList != m_extralRectList) {
+            if (!m_extralRegisterKey.isEmpty()) {
+#ifdef QT_DEBUG
+                bool ret = m_extralEventInter->UnregisterArea(m_extralRegisterKey);
+                qDebug() << "取消任务栏外部区域监听:" << ret;
+#else
+                m_extralEventInter->UnregisterArea(m_extralRegisterKey);
+#endif
+            }
+            m_extralRectList = extralRectList;
+            m_extralRegisterKey = m_extralEventInter->RegisterAreas(m_extralRectList, flags);
+        }
+    }
+
+    // 触屏的按下和抬起还是通过XEventMonitor服务获取
+    if (m_touchRegisterKey.isEmpty() || touchRectList != m_touchRectList) {
+        if (!m_touchRegisterKey.isEmpty())
+            m_touchEventInter->UnregisterArea(m_touchRegisterKey);
+
+        m_touchRectList = touchRectList;
+        m_touchRegisterKey = m_touchEventInter->RegisterAreas(m_touchRectList, flags);
+    }
 }
 
 /**
@@ -542,6 +582,10 @@ void MultiScreenWorker::initMembers()
 
     m_delayWakeTimer->setSingleShot(true);
 
+    // XInput2可用时在进程内判断鼠标是否进入唤起区域，否则还是通过XEventMonitor服务
+    if (!m_edgeMonitor->start())
+        qInfo() << "pointer edge monitor is not available, use XEventMonitor";
+
     setStates(LauncherDisplay, m_launcherInter->isValid() ? m_launcherInter->visible() : false);
 
     // init check
@@ -561,6 +605,14 @@ void MultiScreenWorker::initConnection()
 
     connect(m_delayWakeTimer, &QTimer::timeout, this, &MultiScreenWorker::onRequestDelayShowDock);
 
+    connect(m_edgeMonitor, &PointerEdgeMonitor::cursorMove, this, [ this ](int x, int y) {
+        if (!testState(MousePress))
+            tryToShowDock(x, y);
+    });
+    connect(m_edgeMonitor, &PointerEdgeMonitor::cursorOut, this, &MultiScreenWorker::onCursorOut);
+    connect(m_edgeMonitor, &PointerEdgeMonitor::buttonPress, this, [ this ] { setStates(MousePress, true); });
+    connect(m_edgeMonitor, &PointerEdgeMonitor::buttonRelease, this, [ this ] { setStates(MousePress, false); });
+
     // 刷新所有显示的内容，布局，方向，大小，位置等
     connect(m_monitorUpdateTimer, &QTimer::timeout, this, &MultiScreenWorker::updateDisplay);
 }
@@ -781,18 +833,7 @@ void MultiScreenWorker::checkXEventMonitorService()
         connect(eventInter, &XEventMonitor::ButtonPress, this, [ = ] { setStates(MousePress, true); });
         connect(eventInter, &XEventMonitor::ButtonRelease, this, [ = ] { setStates(MousePress, false); });
 
-        connect(extralEventInter, &XEventMonitor::CursorOut, this, [ = ](int x, int y, const QString &key) {
-            if (isCursorOut(x, y)) {
-                if (testState(ShowAnimationStart)) {
-                    // 在OUT后如果检测到当前的动画正在进行，在out后延迟500毫秒等动画结束再执行移出动画
-                    QTimer::singleShot(500, this, [ = ] {
-                        onExtralRegionMonitorChanged(x, y, key);
-                    });
-                } else {
-                    onExtralRegionMonitorChanged(x, y, key);
-                }
-            }
-        });
+        connect(extralEventInter, &XEventMonitor::CursorOut, this, &MultiScreenWorker::onExtralRegionMonitorChanged);
 
         // 触屏时，后端只发送press、release消息，有move消息则为鼠标，press置false
         connect(touchEventInter, &XEventMonitor::CursorMove, this, [ = ] { setStates(TouchPress, false); });
@@ -816,6 +857,12 @@ void MultiScreenWorker::checkXEventMonitorService()
                 // connect
                 connectionInit(m_eventInter, m_extralEventInter, m_touchEventInter);
 
+                // 之前的注册都是无效的，需要重新注册一次
+                m_registerKey.clear();
+                m_extralRegisterKey.clear();
+                m_touchRegisterKey.clear();
+                onRequestUpdateRegionMonitor();
+
                 disconnect(ifc);
             }
         });
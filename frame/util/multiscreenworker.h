@@ -50,6 +50,7 @@ class MainWindow;
 class QGSettings;
 class TrayMainWindow;
 class MenuWorker;
+class PointerEdgeMonitor;
 
 class MultiScreenWorker : public QObject
 {
@@ -121,6 +122,7 @@ private slots:
     // Region Monitor
     void onRegionMonitorChanged(int x, int y, const QString &key);
     void onExtralRegionMonitorChanged(int x, int y, const QString &key);
+    void onCursorOut(int x, int y);
 
     void updateDisplay();
 
@@ -160,6 +162,7 @@ private:
 
     void checkDaemonDockService();
     void checkXEventMonitorService();
+    void leaveDockArea();
 
     QString getValidScreen(const Position &pos);
 
@@ -174,6 +177,7 @@ private:
     XEventMonitor *m_eventInter;
     XEventMonitor *m_extralEventInter;
     XEventMonitor *m_touchEventInter;
+    PointerEdgeMonitor *m_edgeMonitor;          // 进程内监听鼠标移动，不可用时使用XEventMonitor服务
 
     // DBus interface
     DockInter *m_dockInter;
@@ -0,0 +1,283 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "performancetracer.h"
+#include "constants.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QFile>
+#include <QDebug>
+
+#include <algorithm>
+#include <time.h>
+
+#define MAX_TRACE_EVENTS 100000
+#define MAX_INPUT_LATENCY (10 * 1000)   // 超过10秒的延迟认为时间戳不是单调时钟(比如wayland下)，不统计
+#define MAX_FRAME_INTERVAL (1000 * 1000) // 帧间隔超过1秒认为是新的一次动画
+
+static const char *PaintCategory = "paint";
+static const char *InputCategory = "input";
+static const char *InputLatencyCategory = "input-latency";
+static const char *DBusCategory = "dbus-to-paint";
+static const char *AnimationCategory = "animation";
+
+PerformanceTracer::PerformanceTracer(QObject *parent)
+    : QObject(parent)
+    , m_enabled(false)
+    , m_eventHead(0)
+    , m_pendingSignalTime(-1)
+{
+    m_clock.start();
+
+    const QString outputFile = qEnvironmentVariable("DOCK_TRACE_OUTPUT");
+    if (qEnvironmentVariableIntValue("DOCK_TRACE") > 0 || !outputFile.isEmpty())
+        setEnabled(true);
+
+    if (!outputFile.isEmpty() && qApp) {
+        connect(qApp, &QCoreApplication::aboutToQuit, this, [ this, outputFile ] {
+            exportTrace(outputFile);
+        });
+    }
+}
+
+/**
+ * @brief PerformanceTracer::instance 任务栏和插件中各自有一份PerformanceTracer的代码，第一次使用的模块创建实例并记录在qApp的属性中，
+ * 其他模块使用同一个实例，这样DBus接口打开追踪时插件中的记录也会打开，退出时也只会导出一次
+ */
+PerformanceTracer *PerformanceTracer::instance()
+{
+    static PerformanceTracer *tracer = [] {
+        if (!qApp)
+            return new PerformanceTracer;
+
+        const QVariant value = qApp->property(PROP_PERFORMANCE_TRACER);
+        if (value.isValid())
+            return static_cast<PerformanceTracer *>(value.value<void *>());
+
+        PerformanceTracer *sharedTracer = new PerformanceTracer;
+        qApp->setProperty(PROP_PERFORMANCE_TRACER, QVariant::fromValue(static_cast<void *>(sharedTracer)));
+        return sharedTracer;
+    }();
+
+    return tracer;
+}
+
+void PerformanceTracer::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+
+    m_enabled = enabled;
+    m_pendingSignal.clear();
+    m_pendingSignalTime = -1;
+    m_lastFrameTime.clear();
+
+    qInfo() << "dock performance tracing" << (enabled ? "enabled" : "disabled");
+}
+
+void PerformanceTracer::clear()
+{
+    m_events.clear();
+    m_eventHead = 0;
+    m_statistics.clear();
+    m_pendingSignal.clear();
+    m_pendingSignalTime = -1;
+    m_lastFrameTime.clear();
+}
+
+void PerformanceTracer::recordPaint(const QString &widget, qint64 start, qint64 duration)
+{
+    if (!m_enabled)
+        return;
+
+    append(widget, PaintCategory, start, duration);
+    addStatistics(PaintCategory, widget, duration);
+
+    // DBus信号到达之后的第一次重绘，记录从信号到达到重绘完成的时间
+    if (m_pendingSignalTime >= 0) {
+        const qint64 end = start + duration;
+        append(m_pendingSignal, DBusCategory, m_pendingSignalTime, end - m_pendingSignalTime);
+        addStatistics(DBusCategory, m_pendingSignal, end - m_pendingSignalTime);
+        m_pendingSignal.clear();
+        m_pendingSignalTime = -1;
+    }
+}
+
+/**
+ * @brief PerformanceTracer::recordInput 记录输入事件的处理耗时和分发延迟
+ * @param timestamp 窗口系统给的事件时间戳(毫秒)，X11下是CLOCK_MONOTONIC的时间，用来计算事件从产生到开始处理的延迟
+ */
+void PerformanceTracer::recordInput(const QString &receiver, QEvent::Type type, ulong timestamp, qint64 start, qint64 duration)
+{
+    if (!m_enabled)
+        return;
+
+    const QString typeName = QString::fromLatin1(QMetaEnum::fromType<QEvent::Type>().valueToKey(type));
+
+    qint64 latency = -1;
+    if (timestamp > 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        // X11的时间戳是32位的毫秒数，按32位计算差值以处理回绕
+        const quint32 nowMsecs = static_cast<quint32>(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+        const quint32 delta = nowMsecs - static_cast<quint32>(timestamp);
+        if (delta <= MAX_INPUT_LATENCY) {
+            // 时间戳是记录之前取的，减去事件处理的耗时得到开始处理时的延迟
+            latency = qMax<qint64>(0, static_cast<qint64>(delta) * 1000 - duration);
+            addStatistics(InputLatencyCategory, typeName, latency);
+        }
+    }
+
+    append(QString("%1 %2").arg(typeName).arg(receiver), InputCategory, start, duration, latency);
+    addStatistics(InputCategory, typeName, duration);
+}
+
+void PerformanceTracer::markDBusSignal(const QString &name)
+{
+    if (!m_enabled)
+        return;
+
+    // 多个信号在同一次重绘前到达时，从最早到达的信号开始计算
+    if (m_pendingSignalTime >= 0)
+        return;
+
+    m_pendingSignal = name;
+    m_pendingSignalTime = now();
+}
+
+void PerformanceTracer::recordAnimationFrame(const QString &name)
+{
+    if (!m_enabled)
+        return;
+
+    const qint64 timestamp = now();
+    const qint64 lastTime = m_lastFrameTime.value(name, -1);
+    m_lastFrameTime[name] = timestamp;
+
+    if (lastTime < 0 || timestamp - lastTime > MAX_FRAME_INTERVAL)
+        return;
+
+    append(name, AnimationCategory, timestamp, 0, timestamp - lastTime);
+    addStatistics(AnimationCategory, name, timestamp - lastTime);
+}
+
+/**
+ * @brief PerformanceTracer::traceEvents 导出为Chrome trace-event格式
+ * 耗时类的记录为完整事件(ph=X)，动画帧间隔为计数事件(ph=C)，时间单位为微秒
+ */
+QByteArray PerformanceTracer::traceEvents() const
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    for (int i = 0; i < m_events.size(); ++i) {
+        const TraceEvent &event = m_events.at((m_eventHead + i) % m_events.size());
+
+        QJsonObject object;
+        object["name"] = event.name;
+        object["cat"] = QString::fromLatin1(event.category);
+        object["ts"] = event.timestamp;
+        object["pid"] = pid;
+        object["tid"] = 1;
+        if (event.category == AnimationCategory) {
+            object["ph"] = "C";
+            object["args"] = QJsonObject {{ "interval_us", event.value }};
+        } else {
+            object["ph"] = "X";
+            object["dur"] = event.duration;
+            if (event.value >= 0)
+                object["args"] = QJsonObject {{ "latency_us", event.value }};
+        }
+        events.append(object);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool PerformanceTracer::exportTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "export dock trace failed:" << fileName << file.errorString();
+        return false;
+    }
+
+    return file.write(traceEvents()) >= 0;
+}
+
+/**
+ * @brief PerformanceTracer::summary 按分类汇总的统计信息，每个分类按总耗时从大到小排列
+ */
+QString PerformanceTracer::summary() const
+{
+    QMap<QString, QList<QPair<QString, Statistics>>> categories;
+    for (auto it = m_statistics.constBegin(); it != m_statistics.constEnd(); ++it) {
+        const int index = it.key().indexOf('/');
+        categories[it.key().left(index)].append(qMakePair(it.key().mid(index + 1), it.value()));
+    }
+
+    QJsonObject root;
+    root["enabled"] = m_enabled;
+    root["events"] = m_events.size();
+    for (auto it = categories.begin(); it != categories.end(); ++it) {
+        QList<QPair<QString, Statistics>> &items = it.value();
+        std::sort(items.begin(), items.end(), [ ](const QPair<QString, Statistics> &a, const QPair<QString, Statistics> &b) {
+            return a.second.total > b.second.total;
+        });
+
+        QJsonArray array;
+        for (const QPair<QString, Statistics> &item : items) {
+            QJsonObject object;
+            object["name"] = item.first;
+            object["count"] = item.second.count;
+            object["total_us"] = item.second.total;
+            object["avg_us"] = item.second.total / qMax(1, item.second.count);
+            object["max_us"] = item.second.max;
+            array.append(object);
+        }
+        root[it.key()] = array;
+    }
+
+    return QString::fromUtf8(QJsonDocument(root).toJson(QJsonDocument::Indented));
+}
+
+QString PerformanceTracer::describe(QObject *object)
+{
+    if (!object)
+        return QString();
+
+    const QString className = QString::fromLatin1(object->metaObject()->className());
+    if (object->objectName().isEmpty())
+        return className;
+
+    return QString("%1#%2").arg(className).arg(object->objectName());
+}
+
+void PerformanceTracer::append(const QString &name, const char *category, qint64 timestamp, qint64 duration, qint64 value)
+{
+    const TraceEvent event { name, category, timestamp, duration, value };
+    if (m_events.size() < MAX_TRACE_EVENTS) {
+        m_events.append(event);
+        return;
+    }
+
+    m_events[m_eventHead] = event;
+    m_eventHead = (m_eventHead + 1) % MAX_TRACE_EVENTS;
+}
+
+void PerformanceTracer::addStatistics(const char *category, const QString &name, qint64 value)
+{
+    Statistics &statistics = m_statistics[QString("%1/%2").arg(category).arg(name)];
+    statistics.count++;
+    statistics.total += value;
+    statistics.max = qMax(statistics.max, value);
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef PERFORMANCETRACER_H
+#define PERFORMANCETRACER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QEvent>
+
+/** 任务栏内置的性能追踪
+ * @brief The PerformanceTracer class
+ * 记录控件paintEvent的耗时和次数、输入事件的分发延迟、DBus信号到界面重绘的时间以及动画的帧间隔，
+ * 通过环境变量DOCK_TRACE=1或者DBus接口SetTracingEnabled打开，
+ * 数据可以导出为Chrome trace-event格式的json(chrome://tracing或者perfetto中打开)，也可以通过DBus获取汇总信息，
+ * 设置了DOCK_TRACE_OUTPUT的时候退出时自动导出到对应的文件
+ * 插件管理和托盘插件中也编译了这个类，instance()通过qApp的属性让整个进程共用一个实例
+ */
+class PerformanceTracer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static PerformanceTracer *instance();
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+    void clear();
+
+    qint64 now() const { return m_clock.nsecsElapsed() / 1000; }
+
+    void recordPaint(const QString &widget, qint64 start, qint64 duration);
+    void recordInput(const QString &receiver, QEvent::Type type, ulong timestamp, qint64 start, qint64 duration);
+    void markDBusSignal(const QString &name);
+    void recordAnimationFrame(const QString &name);
+
+    QByteArray traceEvents() const;
+    bool exportTrace(const QString &fileName) const;
+    QString summary() const;
+
+    static QString describe(QObject *object);
+
+private:
+    explicit PerformanceTracer(QObject *parent = nullptr);
+
+    struct TraceEvent {
+        QString name;
+        const char *category;
+        qint64 timestamp;
+        qint64 duration;
+        qint64 value;                                   // 计数类事件(ph=C)的值
+    };
+
+    struct Statistics {
+        int count = 0;
+        qint64 total = 0;
+        qint64 max = 0;
+    };
+
+    void append(const QString &name, const char *category, qint64 timestamp, qint64 duration, qint64 value = -1);
+    void addStatistics(const char *category, const QString &name, qint64 value);
+
+private:
+    bool m_enabled;
+    QElapsedTimer m_clock;
+    QVector<TraceEvent> m_events;                       // 环形缓冲区，超过上限后覆盖最早的记录
+    int m_eventHead;
+    QHash<QString, Statistics> m_statistics;            // key为"分类/名称"
+    QString m_pendingSignal;                            // 最近一次还没有引起重绘的DBus信号
+    qint64 m_pendingSignalTime;
+    QHash<QString, qint64> m_lastFrameTime;
+};
+
+#endif // PERFORMANCETRACER_H
@@ -4,6 +4,7 @@
 
 #include "platformutils.h"
 #include "utils.h"
+#include "x11atoms.h"
 
 #include <QX11Info>
 
@@ -37,7 +38,7 @@ QString PlatformUtils::getWindowProperty(quint32 winId, QString propName)
         return QString();
     }
 
-    Atom atom_prop = XInternAtom(display, propName.toLocal8Bit(), true);
+    const Atom atom_prop = X11Atoms::instance()->atom(propName.toLocal8Bit());
     if (!atom_prop) {
         qDebug() << "Error: get window property failed, invalid property atom";
         return QString();
@@ -0,0 +1,267 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "pointeredgemonitor.h"
+#include "utils.h"
+
+#include <QCoreApplication>
+#include <QX11Info>
+#include <QTimer>
+#include <QDebug>
+
+#include <xcb/xinput.h>
+
+#define NEAR_CHECK_INTERVAL 16          // 鼠标在监听区域附近时按帧查询
+#define FAR_CHECK_INTERVAL 50           // 鼠标远离监听区域时降低查询频率
+#define NEAR_DISTANCE 200               // 在FAR_CHECK_INTERVAL内鼠标很难移动超过这个距离
+
+PointerEdgeMonitor::PointerEdgeMonitor(QObject *parent)
+    : QObject(parent)
+    , m_connection(nullptr)
+    , m_rootWindow(XCB_WINDOW_NONE)
+    , m_xinputOpcode(0)
+    , m_active(false)
+    , m_checkTimer(new QTimer(this))
+    , m_motionPending(false)
+    , m_queryPending(false)
+    , m_queryCookie()
+    , m_inDockArea(false)
+{
+    m_checkTimer->setSingleShot(true);
+    m_checkTimer->setInterval(NEAR_CHECK_INTERVAL);
+    connect(m_checkTimer, &QTimer::timeout, this, &PointerEdgeMonitor::checkPointer);
+}
+
+PointerEdgeMonitor::~PointerEdgeMonitor()
+{
+    if (m_active)
+        qApp->removeNativeEventFilter(this);
+}
+
+/**
+ * @brief PointerEdgeMonitor::start 在根窗口上选择XInput2的原始鼠标事件
+ * @return XInput2可用并且监听成功时返回true
+ */
+bool PointerEdgeMonitor::start()
+{
+    if (m_active)
+        return true;
+
+    if (Utils::IS_WAYLAND_DISPLAY || !QX11Info::isPlatformX11())
+        return false;
+
+    m_connection = QX11Info::connection();
+    m_rootWindow = QX11Info::appRootWindow();
+    if (!m_connection || m_rootWindow == XCB_WINDOW_NONE)
+        return false;
+
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(m_connection, &xcb_input_id);
+    if (!extension || !extension->present) {
+        qWarning() << "XInput extension is not available, use XEventMonitor instead";
+        return false;
+    }
+
+    // 原始事件需要XInput 2.0及以上版本
+    xcb_input_xi_query_version_cookie_t versionCookie = xcb_input_xi_query_version(m_connection, 2, 0);
+    xcb_input_xi_query_version_reply_t *versionReply = xcb_input_xi_query_version_reply(m_connection, versionCookie, nullptr);
+    const bool versionValid = versionReply && versionReply->major_version >= 2;
+    free(versionReply);
+    if (!versionValid) {
+        qWarning() << "XInput2 is not available, use XEventMonitor instead";
+        return false;
+    }
+
+    m_xinputOpcode = extension->major_opcode;
+
+    struct {
+        xcb_input_event_mask_t head;
+        uint32_t mask;
+    } eventMask;
+    eventMask.head.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+    eventMask.head.mask_len = 1;
+    eventMask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_MOTION
+            | XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_PRESS
+            | XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_RELEASE;
+
+    xcb_generic_error_t *error = xcb_request_check(m_connection, xcb_input_xi_select_events_checked(m_connection, m_rootWindow, 1, &eventMask.head));
+    if (error) {
+        qWarning() << "select XInput2 raw events failed:" << error->error_code;
+        free(error);
+        return false;
+    }
+
+    qApp->installNativeEventFilter(this);
+    m_active = true;
+
+    // 只在启动时同步查询一次
+    QPoint pos;
+    if (queryPointer(pos))
+        m_lastPos = pos;
+
+    return true;
+}
+
+void PointerEdgeMonitor::setEdgeAreas(const QList<MonitRect> &areas)
+{
+    m_edgeAreas = areas;
+    updateNearArea();
+}
+
+void PointerEdgeMonitor::setDockAreas(const QList<MonitRect> &areas)
+{
+    m_dockAreas = areas;
+    updateNearArea();
+    // 区域变化不算鼠标离开，只更新当前的状态
+    m_inDockArea = contains(m_dockAreas, m_lastPos);
+}
+
+bool PointerEdgeMonitor::nativeEventFilter(const QByteArray &eventType, void *message, long *result)
+{
+    Q_UNUSED(result);
+
+    if (!m_active || eventType != "xcb_generic_event_t")
+        return false;
+
+    xcb_generic_event_t *event = static_cast<xcb_generic_event_t *>(message);
+    if ((event->response_type & ~0x80) != XCB_GE_GENERIC)
+        return false;
+
+    xcb_ge_generic_event_t *genericEvent = reinterpret_cast<xcb_ge_generic_event_t *>(event);
+    if (genericEvent->extension != m_xinputOpcode)
+        return false;
+
+    switch (genericEvent->event_type) {
+    case XCB_INPUT_RAW_MOTION:
+        // 原始事件中没有鼠标坐标，合并到下一帧中统一查询一次
+        requestCheck();
+        return true;
+    case XCB_INPUT_RAW_BUTTON_PRESS:
+    case XCB_INPUT_RAW_BUTTON_RELEASE:
+        // 不在事件过滤器中同步查询，取到鼠标位置之后再判断是否在唤起区域内
+        m_pendingButtons << genericEvent->event_type;
+        requestCheck();
+        return true;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+void PointerEdgeMonitor::requestCheck()
+{
+    m_motionPending = true;
+    if (!m_checkTimer->isActive())
+        m_checkTimer->start();
+}
+
+/**
+ * @brief PointerEdgeMonitor::checkPointer 取回上一次查询的结果，鼠标移动过时再发出下一次查询，
+ * 查询是异步的，不会在主线程中等待X服务器
+ */
+void PointerEdgeMonitor::checkPointer()
+{
+    if (m_queryPending) {
+        xcb_query_pointer_reply_t *reply = nullptr;
+        xcb_generic_error_t *error = nullptr;
+        if (!xcb_poll_for_reply(m_connection, m_queryCookie.sequence, reinterpret_cast<void **>(&reply), &error)) {
+            // 还没有返回，下一帧再取
+            m_checkTimer->start(NEAR_CHECK_INTERVAL);
+            return;
+        }
+
+        m_queryPending = false;
+        if (reply) {
+            handlePointer(QPoint(reply->root_x, reply->root_y));
+            free(reply);
+        }
+        m_queryButtons.clear();
+        free(error);
+    }
+
+    if (!m_motionPending)
+        return;
+
+    // 查询发出之后的按键事件等待下一次查询的结果
+    m_motionPending = false;
+    m_queryButtons = m_pendingButtons;
+    m_pendingButtons.clear();
+    m_queryCookie = xcb_query_pointer(m_connection, m_rootWindow);
+    m_queryPending = true;
+    xcb_flush(m_connection);
+
+    // 有按键事件时尽快取回结果，否则远离监听区域时降低查询频率
+    const bool near = !m_queryButtons.isEmpty() || m_inDockArea || m_nearArea.contains(m_lastPos);
+    m_checkTimer->start(near ? NEAR_CHECK_INTERVAL : FAR_CHECK_INTERVAL);
+}
+
+void PointerEdgeMonitor::handlePointer(const QPoint &pos)
+{
+    // 远离监听区域时只记录位置，不做区域判断
+    if (!m_inDockArea && !m_nearArea.contains(pos)) {
+        m_lastPos = pos;
+        return;
+    }
+
+    const bool inEdgeArea = contains(m_edgeAreas, pos);
+    for (quint16 button : m_queryButtons) {
+        if (!inEdgeArea)
+            break;
+
+        if (button == XCB_INPUT_RAW_BUTTON_PRESS)
+            Q_EMIT buttonPress(pos.x(), pos.y());
+        else
+            Q_EMIT buttonRelease(pos.x(), pos.y());
+    }
+
+    if (pos == m_lastPos)
+        return;
+
+    m_lastPos = pos;
+
+    if (inEdgeArea)
+        Q_EMIT cursorMove(pos.x(), pos.y());
+
+    const bool inDockArea = contains(m_dockAreas, pos);
+    if (m_inDockArea && !inDockArea)
+        Q_EMIT cursorOut(pos.x(), pos.y());
+
+    m_inDockArea = inDockArea;
+}
+
+void PointerEdgeMonitor::updateNearArea()
+{
+    QRect nearArea;
+    for (const QList<MonitRect> &areas : { m_edgeAreas, m_dockAreas }) {
+        for (const MonitRect &rect : areas)
+            nearArea |= QRect(QPoint(rect.x1, rect.y1), QPoint(rect.x2, rect.y2));
+    }
+
+    m_nearArea = nearArea.adjusted(-NEAR_DISTANCE, -NEAR_DISTANCE, NEAR_DISTANCE, NEAR_DISTANCE);
+}
+
+bool PointerEdgeMonitor::queryPointer(QPoint &pos) const
+{
+    xcb_query_pointer_cookie_t cookie = xcb_query_pointer(m_connection, m_rootWindow);
+    xcb_query_pointer_reply_t *reply = xcb_query_pointer_reply(m_connection, cookie, nullptr);
+    if (!reply)
+        return false;
+
+    pos = QPoint(reply->root_x, reply->root_y);
+    free(reply);
+
+    return true;
+}
+
+bool PointerEdgeMonitor::contains(const QList<MonitRect> &areas, const QPoint &pos)
+{
+    // 和XEventMonitor保持一致，区域的边界也算在区域内
+    for (const MonitRect &rect : areas) {
+        if (pos.x() >= rect.x1 && pos.x() <= rect.x2 && pos.y() >= rect.y1 && pos.y() <= rect.y2)
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,79 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef POINTEREDGEMONITOR_H
+#define POINTEREDGEMONITOR_H
+
+#include "arealist.h"
+
+#include <QObject>
+#include <QPoint>
+#include <QRect>
+#include <QAbstractNativeEventFilter>
+
+#include <xcb/xcb.h>
+
+class QTimer;
+
+/** 在任务栏进程内监听鼠标是否进入唤起区域或离开任务栏区域
+ * @brief The PointerEdgeMonitor class
+ * 通过XInput2在根窗口上监听原始的鼠标移动和按键事件，只在进出监听区域时才发出信号，
+ * 不再需要XEventMonitor服务把每一次鼠标移动都通过DBus转发过来。
+ * 原始事件中没有坐标，鼠标位置按帧异步查询，鼠标远离监听区域时降低查询频率，
+ * X11下XInput2不可用或者在wayland下时start()返回false，由调用者继续使用XEventMonitor服务
+ */
+
+class PointerEdgeMonitor : public QObject, public QAbstractNativeEventFilter
+{
+    Q_OBJECT
+
+public:
+    explicit PointerEdgeMonitor(QObject *parent = nullptr);
+    ~PointerEdgeMonitor() override;
+
+    bool start();
+    bool isActive() const { return m_active; }
+
+    void setEdgeAreas(const QList<MonitRect> &areas);
+    void setDockAreas(const QList<MonitRect> &areas);
+
+Q_SIGNALS:
+    void cursorMove(int x, int y);          // 鼠标在唤起区域内移动
+    void cursorOut(int x, int y);           // 鼠标离开任务栏区域
+    void buttonPress(int x, int y);         // 在唤起区域内按下鼠标
+    void buttonRelease(int x, int y);       // 在唤起区域内释放鼠标
+
+protected:
+    bool nativeEventFilter(const QByteArray &eventType, void *message, long *result) override;
+
+private Q_SLOTS:
+    void checkPointer();
+
+private:
+    void requestCheck();
+    bool queryPointer(QPoint &pos) const;
+    void handlePointer(const QPoint &pos);
+    void updateNearArea();
+    static bool contains(const QList<MonitRect> &areas, const QPoint &pos);
+
+private:
+    xcb_connection_t *m_connection;
+    xcb_window_t m_rootWindow;
+    quint8 m_xinputOpcode;
+    bool m_active;
+    QTimer *m_checkTimer;                   // 一帧内的多个移动事件只查询一次鼠标位置
+    bool m_motionPending;                   // 上一次查询之后鼠标又移动过
+    bool m_queryPending;                    // 已经发出查询，还没有取回结果
+    xcb_query_pointer_cookie_t m_queryCookie;
+    QList<quint16> m_pendingButtons;        // 等待下一次查询的按键事件
+    QList<quint16> m_queryButtons;          // 等待当前查询结果的按键事件
+    bool m_inDockArea;
+    QPoint m_lastPos;
+    QRect m_nearArea;                       // 监听区域向外扩展一段距离，鼠标在这个范围外时不做区域判断
+    QList<MonitRect> m_edgeAreas;
+    QList<MonitRect> m_dockAreas;
+};
+
+#endif // POINTEREDGEMONITOR_H
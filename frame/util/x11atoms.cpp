@@ -0,0 +1,112 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "x11atoms.h"
+#include "utils.h"
+
+#include <QX11Info>
+#include <QDebug>
+#include <QVector>
+
+#include <X11/Xlib.h>
+#include <xcb/xcb.h>
+
+// 和X11Atoms::AtomType的顺序一一对应
+static const char *atomNames[X11Atoms::AtomCount] = {
+    "WM_PROTOCOLS",
+    "WM_DELETE_WINDOW",
+    "WM_CLASS",
+    "CARDINAL",
+    "_NET_WM_PID",
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_WINDOW_OPACITY",
+    "_GTK_FRAME_EXTENTS",
+    "__wine_prefix"
+};
+
+X11Atoms::X11Atoms()
+{
+    QList<QByteArray> names;
+    for (int i = 0; i < AtomCount; ++i)
+        names << QByteArray(atomNames[i]);
+
+    // 表中的atom不使用only_if_exists，否则启动时还不存在的atom会一直保存为0
+    internAtoms(names, m_atoms, false);
+}
+
+/**
+ * @brief X11Atoms::atom 按名称获取atom，表中有的直接返回，其他的只在第一次使用时和X服务器交互
+ * 不在表中的atom使用only_if_exists获取，不存在时返回0，调用者可以据此判断没有窗口设置过这个属性
+ */
+quint32 X11Atoms::atom(const QByteArray &name)
+{
+    if (name.isEmpty())
+        return 0;
+
+    for (int i = 0; i < AtomCount; ++i) {
+        if (name == atomNames[i])
+            return m_atoms[i];
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_extraAtoms.constFind(name);
+    if (it != m_extraAtoms.constEnd())
+        return it.value();
+
+    quint32 value = 0;
+    internAtoms({ name }, &value, true);
+    // 还不存在时不缓存，下次再查
+    if (value != 0)
+        m_extraAtoms.insert(name, value);
+
+    return value;
+}
+
+/**
+ * @brief X11Atoms::internAtoms 先发出所有的请求再依次取回复，整批只需要一次往返
+ */
+void X11Atoms::internAtoms(const QList<QByteArray> &names, quint32 *atoms, bool onlyIfExists) const
+{
+    for (int i = 0; i < names.size(); ++i)
+        atoms[i] = 0;
+
+    xcb_connection_t *connection = Utils::IS_WAYLAND_DISPLAY ? nullptr : QX11Info::connection();
+    if (connection) {
+        QVector<xcb_intern_atom_cookie_t> cookies;
+        cookies.reserve(names.size());
+        for (const QByteArray &name : names)
+            cookies << xcb_intern_atom(connection, onlyIfExists, static_cast<uint16_t>(name.size()), name.constData());
+
+        for (int i = 0; i < cookies.size(); ++i) {
+            xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(connection, cookies[i], nullptr);
+            if (!reply)
+                continue;
+
+            atoms[i] = reply->atom;
+            free(reply);
+        }
+        return;
+    }
+
+    // wayland下没有Qt的X连接，通过XWayland获取，XInternAtoms同样是一次往返，atom的值在同一个X服务器上是通用的
+    Display *display = XOpenDisplay(nullptr);
+    if (!display) {
+        qWarning() << "Error: get display failed!";
+        return;
+    }
+
+    QVector<char *> nameList;
+    nameList.reserve(names.size());
+    for (const QByteArray &name : names)
+        nameList << const_cast<char *>(name.constData());
+
+    QVector<Atom> values(names.size(), 0);
+    XInternAtoms(display, nameList.data(), nameList.size(), onlyIfExists, values.data());
+    for (int i = 0; i < values.size(); ++i)
+        atoms[i] = static_cast<quint32>(values[i]);
+
+    XCloseDisplay(display);
+}
@@ -0,0 +1,53 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef X11ATOMS_H
+#define X11ATOMS_H
+
+#include "singleton.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+
+/** 进程内共用的X11 atom表
+ * @brief The X11Atoms class
+ * 常用的atom在启动时一次性发出所有的intern请求再统一取回复，只和X服务器往返一次，
+ * 之后判断窗口状态等只需要比较atom的值，不再调用XInternAtom和XGetAtomName
+ */
+class X11Atoms : public Singleton<X11Atoms>
+{
+    friend class Singleton<X11Atoms>;
+
+public:
+    enum AtomType {
+        WM_PROTOCOLS = 0,
+        WM_DELETE_WINDOW,
+        WM_CLASS,
+        CARDINAL,
+        NET_WM_PID,
+        NET_WM_STATE,
+        NET_WM_STATE_HIDDEN,
+        NET_WM_WINDOW_OPACITY,
+        GTK_FRAME_EXTENTS,
+        WINE_PREFIX,
+        AtomCount
+    };
+
+    quint32 atom(AtomType type) const { return m_atoms[type]; }
+    quint32 atom(const QByteArray &name);
+
+private:
+    X11Atoms();
+
+    void internAtoms(const QList<QByteArray> &names, quint32 *atoms, bool onlyIfExists) const;
+
+private:
+    quint32 m_atoms[AtomCount];
+    QMutex m_mutex;
+    QHash<QByteArray, quint32> m_extraAtoms;            // 不在表中并且已经存在的atom，第一次使用时获取后缓存
+};
+
+#endif // X11ATOMS_H
@@ -8,6 +8,7 @@
 #include "dockpopupwindow.h"
 #include "utils.h"
 #include "dbusutil.h"
+#include "clockscheduler.h"
 
 #include <DFontSizeManager>
 #include <DDBusSender>
@@ -36,7 +37,7 @@ DateTimeDisplayer::DateTimeDisplayer(bool showMultiRow, QWidget *parent)
     , m_dateFont(DFontSizeManager::instance()->t10())
     , m_tipsWidget(new Dock::TipsWidget(this))
     , m_menu(new QMenu(this))
-    , m_tipsTimer(new QTimer(this))
+    , m_clockScheduler(new ClockScheduler(nullptr, this))
     , m_currentSize(0)
     , m_oneRow(false)
     , m_showMultiRow(showMultiRow)
@@ -50,11 +51,11 @@ DateTimeDisplayer::DateTimeDisplayer(bool showMultiRow, QWidget *parent)
     // 是否使用24小时制发生变化的时候，也需要重绘
     connect(m_timedateInter, &Timedate::Use24HourFormatChanged, this, &DateTimeDisplayer::onDateTimeFormatChanged);
     // 连接日期时间修改信号,更新日期时间插件的布局
-    connect(m_timedateInter, &Timedate::TimeUpdate, this, static_cast<void (QWidget::*)()>(&DateTimeDisplayer::update));
-    // 连接定时器和时间显示的tips信号,一秒钟触发一次，显示时间
-    connect(m_tipsTimer, &QTimer::timeout, this, &DateTimeDisplayer::onTimeChanged);
-    m_tipsTimer->setInterval(1000);
-    m_tipsTimer->start();
+    connect(m_timedateInter, &Timedate::TimeUpdate, this, &DateTimeDisplayer::onTimeChanged);
+    // 时区变化的时候显示的时间也会跳变，需要立即刷新
+    connect(m_timedateInter, &Timedate::TimezoneChanged, this, &DateTimeDisplayer::onTimeChanged);
+    // 只在显示的时间发生变化的时候唤醒，平时按整分钟对齐，显示提示(带秒)的时候按整秒对齐
+    connect(m_clockScheduler, &ClockScheduler::tick, this, &DateTimeDisplayer::onTimeChanged);
     updatePolicy();
     createMenuItem();
     if (Utils::IS_WAYLAND_DISPLAY)
@@ -238,6 +239,17 @@ DateTimeDisplayer::DateTimeInfo DateTimeDisplayer::dateTimeInfo(const Dock::Posi
 }
 
 void DateTimeDisplayer::onTimeChanged()
+{
+    // 提示窗口没有显示的时候不需要更新秒数，避免每分钟都去格式化提示文本
+    if (m_isEnter)
+        updateTipsText();
+
+    // 如果时间和日期有一个不等，则实时刷新界面
+    if (m_lastDateString != getDateString() || m_lastTimeString != getTimeString())
+        update();
+}
+
+void DateTimeDisplayer::updateTipsText()
 {
     const QDateTime currentDateTime = QDateTime::currentDateTime();
 
@@ -245,10 +257,6 @@ void DateTimeDisplayer::onTimeChanged()
         m_tipsWidget->setText(currentDateTime.date().toString(Qt::SystemLocaleLongDate) + currentDateTime.toString(" HH:mm:ss"));
     else
         m_tipsWidget->setText(currentDateTime.date().toString(Qt::SystemLocaleLongDate) + currentDateTime.toString(" hh:mm:ss AP"));
-
-    // 如果时间和日期有一个不等，则实时刷新界面
-    if (m_lastDateString != getDateString() || m_lastTimeString != getTimeString())
-        update();
 }
 
 void DateTimeDisplayer::onDateTimeFormatChanged()
@@ -396,6 +404,8 @@ void DateTimeDisplayer::enterEvent(QEvent *event)
 {
     Q_UNUSED(event);
     m_isEnter = true;
+    m_clockScheduler->setResolution(ClockScheduler::Second);
+    updateTipsText();
     update();
     m_tipPopupWindow->show(tipsPoint());
 }
@@ -404,10 +414,25 @@ void DateTimeDisplayer::leaveEvent(QEvent *event)
 {
     Q_UNUSED(event);
     m_isEnter = false;
+    m_clockScheduler->setResolution(ClockScheduler::Minute);
     update();
     m_tipPopupWindow->hide();
 }
 
+void DateTimeDisplayer::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    // 隐藏期间没有刷新，显示的时候立即更新一次
+    m_clockScheduler->start();
+    onTimeChanged();
+}
+
+void DateTimeDisplayer::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_clockScheduler->stop();
+}
+
 void DateTimeDisplayer::updateLastData(const DateTimeInfo &info)
 {
     m_lastDateString = info.m_date;
@@ -17,6 +17,7 @@ namespace Dock { class TipsWidget; }
 
 class DockPopupWindow;
 class QMenu;
+class ClockScheduler;
 
 using Timedate = org::deepin::dde::Timedate1;
 
@@ -49,6 +50,8 @@ protected:
     void paintEvent(QPaintEvent *e) override;
     void enterEvent(QEvent *event) override;
     void leaveEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private:
     void updatePolicy();
@@ -62,6 +65,7 @@ private:
 
     QPoint tipsPoint() const;
     QFont timeFont() const;
+    void updateTipsText();
 
     void createMenuItem();
     QRect textRect(const QRect &sourceRect) const;
@@ -77,7 +81,7 @@ private:
     Dock::TipsWidget *m_tipsWidget;
     QMenu *m_menu;
     QSharedPointer<DockPopupWindow> m_tipPopupWindow;
-    QTimer *m_tipsTimer;
+    ClockScheduler *m_clockScheduler;
     QString m_lastDateString;
     QString m_lastTimeString;
     int m_currentSize;
@@ -46,6 +46,8 @@
 
 #include <X11/Xlib.h>
 
+#include <algorithm>
+
 #define SPLITER_SIZE 2
 #define TRASH_MARGIN 20
 #define PLUGIN_MAX_SIZE  40
@@ -82,6 +84,7 @@ MainPanelControl::MainPanelControl(DockInter *dockInter, QWidget *parent)
     , m_recentHelper(new RecentAppHelper(m_appAreaSonWidget, m_recentAreaWidget, m_dockInter, this))
     , m_toolHelper(new ToolAppHelper(m_toolSonAreaWidget, this))
     , m_multiHelper(new MultiWindowHelper(m_appAreaSonWidget, m_multiWindowWidget, this))
+    , m_dockIconLayoutPending(false)
 {
     initUI();
     initConnection();
@@ -387,6 +390,7 @@ void MainPanelControl::insertItem(int index, DockItem *item)
     if (item->itemType() != DockItem::App)
         resizeDockIcon();
 
+    m_hitTestIndex.clear();
     item->checkEntry();
 }
 
@@ -413,6 +417,7 @@ void MainPanelControl::removeItem(DockItem *item)
     }
 
     item->removeEventFilter(this);
+    m_hitTestIndex.clear();
 
     /** 此处重新计算大小的时候icon的个数在原有个数上减少了一个，导致每个icon的大小跟原来大小不一致，需要重新设置setFixedSize
      *  在龙芯处理器上当app数量过多时，会导致拖动app耗时严重，造成卡顿
@@ -431,13 +436,28 @@ void MainPanelControl::moveItem(DockItem *sourceItem, DockItem *targetItem)
 {
     // get target index
     int idx = -1;
+    QBoxLayout *targetLayout = nullptr;
     if (targetItem->itemType() == DockItem::App)
-        idx = m_appAreaSonLayout->indexOf(targetItem);
+        targetLayout = m_appAreaSonLayout;
     else if (targetItem->itemType() == DockItem::FixedPlugin)
-        idx = m_fixedAreaLayout->indexOf(targetItem);
+        targetLayout = m_fixedAreaLayout;
     else
         return;
 
+    idx = targetLayout->indexOf(targetItem);
+
+    // 在同一个区域中调整顺序时只移动布局中的位置，图标的数量没有变化，
+    // 不需要重新计算图标大小、区域的显示状态，也不需要再检查应用的窗口(DBus调用)，拖拽过程中会频繁走到这里
+    if (idx >= 0 && targetLayout->indexOf(sourceItem) >= 0) {
+        if (sourceItem->isDragging())
+            m_dragIndex = idx;
+
+        targetLayout->removeWidget(sourceItem);
+        targetLayout->insertWidget(idx, sourceItem);
+        m_hitTestIndex.remove(targetLayout->parentWidget());
+        return;
+    }
+
     // remove old item
     removeItem(sourceItem);
 
@@ -615,6 +635,10 @@ bool MainPanelControl::eventFilter(QObject *watched, QEvent *event)
     //if (m_tray && watched == m_tray && event->type() == QEvent::Resize)
         //m_tray->pluginItem()->displayModeChanged(m_displayMode);
 
+    // 图标的位置或者大小发生了变化，拖拽时的查找索引需要重新生成
+    if ((event->type() == QEvent::Move || event->type() == QEvent::Resize) && watched->isWidgetType())
+        m_hitTestIndex.remove(static_cast<QWidget *>(watched)->parentWidget());
+
     // 更新应用区域大小和任务栏图标大小
     if (watched == m_appAreaSonWidget) {
         switch (event->type()) {
@@ -717,7 +741,8 @@ void MainPanelControl::mousePressEvent(QMouseEvent *e)
 void MainPanelControl::startDrag(DockItem *dockItem)
 {
     QPointer<DockItem> item = dockItem;
-    const QPixmap pixmap = item->grab();
+    // 使用图标已经缓存好的图片，在setDraging之前获取，拖拽状态下图标不绘制内容
+    const QPixmap pixmap = item->dragPixmap();
 
     item->setDraging(true);
     item->update();
@@ -760,7 +785,7 @@ void MainPanelControl::startDrag(DockItem *dockItem)
 
         appDrag->appDragWidget()->setOriginPos((m_appAreaSonWidget->mapToGlobal(item->pos())));
         appDrag->appDragWidget()->setDockInfo(m_position, QRect(mapToGlobal(pos()), size()));
-        const QPixmap &dragPix = qobject_cast<AppItem *>(item)->appIcon();
+        const QPixmap &dragPix = pixmap;
 
         appDrag->setPixmap(dragPix);
         m_appDragWidget->show();
@@ -845,31 +870,63 @@ DockItem *MainPanelControl::dropTargetItem(DockItem *sourceItem, QPoint point)
         return nullptr;
 
     point = parentWidget->mapFromParent(point);
-    QLayout *parentLayout = parentWidget->layout();
+    DockItem *targetItem = hitTestItem(parentWidget, point);
 
-    DockItem *targetItem = nullptr;
+    if (!targetItem && parentWidget == m_appAreaSonWidget) {
+        // appitem调整顺序是，判断是否拖放在两边空白区域
+        targetItem = sourceItem;
+    }
 
-    for (int i = 0 ; i < parentLayout->count(); ++i) {
-        QLayoutItem *layoutItem = parentLayout->itemAt(i);
+    return targetItem;
+}
 
-        DockItem *dockItem = qobject_cast<DockItem *>(layoutItem->widget());
+/**
+ * @brief MainPanelControl::hitTestItem 查找区域中包含指定坐标的图标
+ * 区域中的图标在布局方向上依次排列，按顺序记录每个图标的起始坐标后二分查找，
+ * 索引只在图标的位置或者大小变化后才重新生成，拖拽过程中每次移动不用再遍历整个布局
+ * @param parentWidget 图标所在的区域
+ * @param point 区域中的坐标
+ * @return 包含该坐标的图标，没有则返回空
+ */
+DockItem *MainPanelControl::hitTestItem(QWidget *parentWidget, const QPoint &point)
+{
+    const bool horizontal = (m_position == Position::Top || m_position == Position::Bottom);
 
-        if (!dockItem)
-            continue;
+    auto it = m_hitTestIndex.find(parentWidget);
+    if (it == m_hitTestIndex.end() || it->horizontal != horizontal) {
+        HitTestIndex index;
+        index.horizontal = horizontal;
 
-        QRect rect(dockItem->pos(), dockItem->size());
-        if (rect.contains(point)) {
-            targetItem = dockItem;
-            break;
+        QLayout *parentLayout = parentWidget->layout();
+        for (int i = 0; parentLayout && i < parentLayout->count(); ++i) {
+            DockItem *dockItem = qobject_cast<DockItem *>(parentLayout->itemAt(i)->widget());
+            if (!dockItem || dockItem->isHidden())
+                continue;
+
+            index.items << qMakePair(horizontal ? dockItem->x() : dockItem->y(), QPointer<DockItem>(dockItem));
         }
-    }
 
-    if (!targetItem && parentWidget == m_appAreaSonWidget) {
-        // appitem调整顺序是，判断是否拖放在两边空白区域
-        targetItem = sourceItem;
+        std::stable_sort(index.items.begin(), index.items.end(), [](const QPair<int, QPointer<DockItem>> &item1, const QPair<int, QPointer<DockItem>> &item2) {
+            return item1.first < item2.first;
+        });
+
+        it = m_hitTestIndex.insert(parentWidget, index);
     }
 
-    return targetItem;
+    const QVector<QPair<int, QPointer<DockItem>>> &items = it->items;
+    const int value = horizontal ? point.x() : point.y();
+    auto found = std::upper_bound(items.cbegin(), items.cend(), value, [](int value, const QPair<int, QPointer<DockItem>> &item) {
+        return value < item.first;
+    });
+
+    if (found == items.cbegin())
+        return nullptr;
+
+    DockItem *dockItem = (found - 1)->second;
+    if (!dockItem || !QRect(dockItem->pos(), dockItem->size()).contains(point))
+        return nullptr;
+
+    return dockItem;
 }
 
 void MainPanelControl::updateDisplayMode()
@@ -1077,13 +1134,23 @@ int MainPanelControl::trayAreaSize(qreal ratio) const
     if (m_displayMode == Dock::DisplayMode::Efficient)
         return (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom ? m_tray->width() * ratio: m_tray->height() * ratio);
 
-    int length = 0;
-    QWidgetList topLevelWidgets = qApp->topLevelWidgets();
-    for (QWidget *widget : topLevelWidgets) {
-        MainWindowBase *topWindow = qobject_cast<MainWindowBase *>(widget);
-        if (!topWindow)
-            continue;
+    // 任务栏的顶层窗口只在启动时创建，缓存下来，避免每次都遍历所有的顶层窗口(包括菜单和提示框等)
+    bool windowsValid = !m_dockWindows.isEmpty();
+    for (const QPointer<MainWindowBase> &topWindow : m_dockWindows)
+        windowsValid = windowsValid && !topWindow.isNull();
+
+    if (!windowsValid) {
+        m_dockWindows.clear();
+        const QWidgetList topLevelWidgets = qApp->topLevelWidgets();
+        for (QWidget *widget : topLevelWidgets) {
+            MainWindowBase *topWindow = qobject_cast<MainWindowBase *>(widget);
+            if (topWindow)
+                m_dockWindows << topWindow;
+        }
+    }
 
+    int length = 0;
+    for (const QPointer<MainWindowBase> &topWindow : m_dockWindows) {
         if (topWindow->windowType() != MainWindowBase::DockWindowType::MainWindow) {
             length += (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom ? topWindow->width() * ratio : topWindow->height() * ratio);
         }
@@ -1094,11 +1161,26 @@ int MainPanelControl::trayAreaSize(qreal ratio) const
     return length;
 }
 
-/**重新计算任务栏上应用图标、插件图标的大小，并设置
+/**请求重新计算任务栏上应用图标、插件图标的大小
  * @brief MainPanelControl::resizeDockIcon
+ * 插入、移除、尺寸变化等都会调用该接口，同一轮事件循环中的多次请求合并成一次计算
  */
 void MainPanelControl::resizeDockIcon()
 {
+    if (m_dockIconLayoutPending)
+        return;
+
+    m_dockIconLayoutPending = true;
+    QMetaObject::invokeMethod(this, &MainPanelControl::updateDockIconLayout, Qt::QueuedConnection);
+}
+
+/**重新计算任务栏上应用图标、插件图标的大小，并设置
+ * @brief MainPanelControl::updateDockIconLayout
+ */
+void MainPanelControl::updateDockIconLayout()
+{
+    m_dockIconLayoutPending = false;
+
     int iconSize = 0;
     // 总宽度
     if (m_displayMode == DisplayMode::Fashion) {
@@ -1178,37 +1260,52 @@ void MainPanelControl::resizeDockIcon()
 void MainPanelControl::calcuDockIconSize(int w, int h)
 {
     int appItemSize = qMin(w, h);
-    for (int i = 0; i < m_fixedAreaLayout->count(); ++i)
-        m_fixedAreaLayout->itemAt(i)->widget()->setFixedSize(appItemSize, appItemSize);
+    const QSize itemSize(appItemSize, appItemSize);
+
+    // 位置、显示模式或者任务栏尺寸变化时，所有区域都需要重新设置大小
+    if (m_layoutState.position != m_position || m_layoutState.displayMode != m_displayMode || m_layoutState.size != QSize(w, h)) {
+        m_layoutState.position = m_position;
+        m_layoutState.displayMode = m_displayMode;
+        m_layoutState.size = QSize(w, h);
+        m_areaLayoutCache.clear();
+
+        if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom) {
+            m_fixedSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
+            m_appSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
+            m_recentSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
+        } else {
+            m_fixedSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
+            m_appSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
+            m_recentSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
+        }
+    }
 
-    if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom) {
-        m_fixedSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
-        m_appSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
-        m_recentSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
-    } else {
-        m_fixedSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
-        m_appSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
-        m_recentSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
+    if (areaLayoutChanged(m_fixedAreaLayout, appItemSize)) {
+        for (int i = 0; i < m_fixedAreaLayout->count(); ++i)
+            setWidgetFixedSize(m_fixedAreaLayout->itemAt(i)->widget(), itemSize);
     }
 
     // 时尚模式下判断是否需要显示最近打开的应用区域
     if (m_displayMode == Dock::DisplayMode::Fashion) {
-        for (int i = 0; i < m_appAreaSonLayout->count(); ++i)
-            m_appAreaSonLayout->itemAt(i)->widget()->setFixedSize(appItemSize, appItemSize);
+        if (areaLayoutChanged(m_appAreaSonLayout, appItemSize)) {
+            for (int i = 0; i < m_appAreaSonLayout->count(); ++i)
+                setWidgetFixedSize(m_appAreaSonLayout->itemAt(i)->widget(), itemSize);
+        }
 
-        if (m_recentLayout->count() > 0) {
+        if (m_recentLayout->count() > 0 && areaLayoutChanged(m_recentLayout, appItemSize)) {
             for (int i = 0; i < m_recentLayout->count(); ++i)
-                m_recentLayout->itemAt(i)->widget()->setFixedSize(appItemSize, appItemSize);
+                setWidgetFixedSize(m_recentLayout->itemAt(i)->widget(), itemSize);
 
             // 时尚模式下计算最近打开应用区域的尺寸
             if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom)
-                m_recentAreaWidget->setFixedSize(appItemSize * m_recentLayout->count(), QWIDGETSIZE_MAX);
+                setWidgetFixedSize(m_recentAreaWidget, QSize(appItemSize * m_recentLayout->count(), QWIDGETSIZE_MAX));
             else
-                m_recentAreaWidget->setFixedSize(QWIDGETSIZE_MAX, appItemSize * m_recentLayout->count());
+                setWidgetFixedSize(m_recentAreaWidget, QSize(QWIDGETSIZE_MAX, appItemSize * m_recentLayout->count()));
         }
 
+        // 多开窗口的尺寸由窗口自己决定，可能在图标大小不变的情况下发生变化，因此每次都需要计算
         if (m_multiWindowLayout->count() > 0) {
-            QList<QSize> multiSizes;
+            int totalSize = 0;
             for (int i = 0; i < m_multiWindowLayout->count(); i++) {
                 // 因为多开窗口的长宽会不一样，因此，需要将当前的尺寸传入
                 // 由它自己来计算自己的长宽尺寸
@@ -1217,50 +1314,43 @@ void MainPanelControl::calcuDockIconSize(int w, int h)
                     continue;
 
                 QSize size = appMultiItem->suitableSize(appItemSize);
-                appMultiItem->setFixedSize(size);
-                multiSizes << size;
+                setWidgetFixedSize(appMultiItem, size);
+                totalSize += (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom) ? size.width() : size.height();
             }
             // 计算多开窗口的尺寸
-            int totalSize = 0;
-            if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom) {
-                for (QSize size : multiSizes)
-                    totalSize += size.width();
-
-                m_multiWindowWidget->setFixedSize(totalSize, appItemSize);
-            } else {
-                for (QSize size : multiSizes)
-                    totalSize += size.height();
-
-                m_multiWindowWidget->setFixedSize(appItemSize, totalSize);
-            }
+            if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom)
+                setWidgetFixedSize(m_multiWindowWidget, QSize(totalSize, appItemSize));
+            else
+                setWidgetFixedSize(m_multiWindowWidget, QSize(appItemSize, totalSize));
         } else {
-            m_multiWindowWidget->setFixedSize(0, 0);
+            setWidgetFixedSize(m_multiWindowWidget, QSize(0, 0));
         }
-        if (m_toolSonLayout->count() > 0) {
+
+        if (m_toolSonLayout->count() > 0 && areaLayoutChanged(m_toolSonLayout, appItemSize)) {
             for (int i = 0; i < m_toolSonLayout->count(); i++)
-                m_toolSonLayout->itemAt(i)->widget()->setFixedSize(appItemSize, appItemSize);
+                setWidgetFixedSize(m_toolSonLayout->itemAt(i)->widget(), itemSize);
 
             if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom) {
-                m_toolSonAreaWidget->setFixedSize(appItemSize * m_toolSonLayout->count(), QWIDGETSIZE_MAX);
+                setWidgetFixedSize(m_toolSonAreaWidget, QSize(appItemSize * m_toolSonLayout->count(), QWIDGETSIZE_MAX));
             } else {
-                m_toolSonAreaWidget->setFixedSize(QWIDGETSIZE_MAX, appItemSize * m_toolSonLayout->count());
+                setWidgetFixedSize(m_toolSonAreaWidget, QSize(QWIDGETSIZE_MAX, appItemSize * m_toolSonLayout->count()));
             }
         }
 
         if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom)
-            m_toolAreaWidget->setFixedSize(m_multiWindowWidget->width() + m_toolSonAreaWidget->width(), QWIDGETSIZE_MAX);
+            setWidgetFixedSize(m_toolAreaWidget, QSize(m_multiWindowWidget->width() + m_toolSonAreaWidget->width(), QWIDGETSIZE_MAX));
         else
-            m_toolAreaWidget->setFixedSize(QWIDGETSIZE_MAX, m_multiWindowWidget->height() + m_toolSonAreaWidget->height());
-    } else {
+            setWidgetFixedSize(m_toolAreaWidget, QSize(QWIDGETSIZE_MAX, m_multiWindowWidget->height() + m_toolSonAreaWidget->height()));
+    } else if (areaLayoutChanged(m_appAreaSonLayout, appItemSize)) {
         for (int i = 0; i < m_appAreaSonLayout->count(); ++i) {
             DockItem *dockItem = qobject_cast<DockItem *>(m_appAreaSonLayout->itemAt(i)->widget());
             if (!dockItem)
                 continue;
             if (dockItem->itemType() == DockItem::ItemType::AppMultiWindow) {
                 AppMultiItem *appMultiItem = qobject_cast<AppMultiItem *>(dockItem);
-                dockItem->setFixedSize(appMultiItem->suitableSize(appItemSize));
+                setWidgetFixedSize(dockItem, appMultiItem->suitableSize(appItemSize));
             } else {
-                dockItem->setFixedSize(appItemSize, appItemSize);
+                setWidgetFixedSize(dockItem, itemSize);
             }
         }
     }
@@ -1278,6 +1368,43 @@ void MainPanelControl::calcuDockIconSize(int w, int h)
     m_appAreaSonLayout->setContentsMargins(appLeftAndRightMargin, appTopAndBottomMargin, appLeftAndRightMargin, appTopAndBottomMargin);
 }
 
+/**判断区域中的图标自上次计算后是否发生变化(增删、排序或者图标大小变化)，并记录本次的状态
+ * @brief MainPanelControl::areaLayoutChanged
+ * @param layout 区域的布局
+ * @param itemSize 本次计算的图标大小
+ * @return 需要重新设置区域中图标的大小时返回true
+ */
+bool MainPanelControl::areaLayoutChanged(QBoxLayout *layout, int itemSize)
+{
+    AreaLayoutCache &cache = m_areaLayoutCache[layout];
+    bool changed = (cache.itemSize != itemSize || cache.widgets.size() != layout->count());
+    for (int i = 0; !changed && i < layout->count(); ++i)
+        changed = (cache.widgets.at(i) != layout->itemAt(i)->widget());
+
+    if (!changed)
+        return false;
+
+    // 使用QPointer记录，图标被释放后即使新图标复用了相同的地址也能识别出来
+    cache.itemSize = itemSize;
+    cache.widgets.clear();
+    cache.widgets.reserve(layout->count());
+    for (int i = 0; i < layout->count(); ++i)
+        cache.widgets << layout->itemAt(i)->widget();
+
+    return true;
+}
+
+/**设置窗口固定大小，大小没有变化时不设置，避免触发布局重新计算
+ * @brief MainPanelControl::setWidgetFixedSize
+ */
+void MainPanelControl::setWidgetFixedSize(QWidget *widget, const QSize &size)
+{
+    if (!widget || (widget->minimumSize() == size && widget->maximumSize() == size))
+        return;
+
+    widget->setFixedSize(size);
+}
+
 void MainPanelControl::onRecentVisibleChanged(bool visible)
 {
     m_appSpliter->setVisible(visible);
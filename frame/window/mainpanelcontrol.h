@@ -10,6 +10,9 @@
 #include "dbusutil.h"
 
 #include <QWidget>
+#include <QPointer>
+#include <QHash>
+#include <QVector>
 
 using namespace Dock;
 
@@ -24,6 +27,7 @@ class DesktopWidget;
 class RecentAppHelper;
 class ToolAppHelper;
 class MultiWindowHelper;
+class MainWindowBase;
 
 class MainPanelControl : public QWidget
 {
@@ -67,9 +71,13 @@ private:
     // 拖拽相关
     void startDrag(DockItem *);
     DockItem *dropTargetItem(DockItem *sourceItem, QPoint point);
+    DockItem *hitTestItem(QWidget *parentWidget, const QPoint &point);
     void moveItem(DockItem *sourceItem, DockItem *targetItem);
     void handleDragMove(QDragMoveEvent *e, bool isFilter);
+    void updateDockIconLayout();
     void calcuDockIconSize(int w, int h);
+    bool areaLayoutChanged(QBoxLayout *layout, int itemSize);
+    void setWidgetFixedSize(QWidget *widget, const QSize &size);
     bool checkNeedShowDesktop();
     bool appIsOnDock(const QString &appDesktop);
     void dockRecentApp(DockItem *dockItem);
@@ -125,6 +133,28 @@ private:
     RecentAppHelper *m_recentHelper;
     ToolAppHelper *m_toolHelper;
     MultiWindowHelper *m_multiHelper;
+
+    // 图标大小计算的缓存，只有发生变化的区域才重新设置图标大小
+    struct AreaLayoutCache {
+        QVector<QPointer<QWidget>> widgets; // 上次计算时区域中的图标
+        int itemSize = -1;                  // 上次计算时的图标大小
+    };
+    struct LayoutState {
+        Position position = Position::Bottom;
+        DisplayMode displayMode = DisplayMode::Efficient;
+        QSize size;
+    };
+    bool m_dockIconLayoutPending;
+    LayoutState m_layoutState;
+    QHash<QBoxLayout *, AreaLayoutCache> m_areaLayoutCache;
+    mutable QList<QPointer<MainWindowBase>> m_dockWindows;
+
+    // 拖拽时查找目标图标的索引，图标的位置或者大小变化后重新生成
+    struct HitTestIndex {
+        bool horizontal = true;
+        QVector<QPair<int, QPointer<DockItem>>> items;  // 图标在布局方向上的起始坐标，从小到大排列
+    };
+    QHash<QWidget *, HitTestIndex> m_hitTestIndex;
 };
 
 #endif // MAINPANELCONTROL_H
@@ -10,6 +10,8 @@
 #include "touchsignalmanager.h"
 #include "displaymanager.h"
 #include "menuworker.h"
+#include "settingconfig.h"
+#include "performancetracer.h"
 
 #include <DStyle>
 #include <DWindowManagerHelper>
@@ -23,6 +25,11 @@
 
 #define DRAG_AREA_SIZE (5)
 
+// 窗口几何变化后的更新每帧最多提交一次
+#define COMMIT_INTERVAL 16
+//INFO 这里要大于动画的300ms，否则动画过程中就会通知后端和窗管
+#define GEOMETRY_SETTLE_TIME 500
+
 // 任务栏圆角最小的时候，任务栏的高度值
 #define MIN_RADIUS_WINDOWSIZE 46
 // 任务栏圆角最小值和最大值的差值
@@ -30,6 +37,9 @@
 // 最小圆角值
 #define MIN_RADIUS 12
 
+// 动画方式，geometry:每一帧都修改窗口的位置和大小，fade:窗口位置和大小只设置一次，通过透明度做动画
+#define DOCK_ANIMATION_MODE "Dock_Animation_Mode"
+
 #define DOCK_SCREEN DockScreen::instance()
 #define DIS_INS DisplayManager::instance()
 
@@ -41,9 +51,12 @@ MainWindowBase::MainWindowBase(MultiScreenWorker *multiScreenWorker, QWidget *pa
     , m_position(Dock::Position::Bottom)
     , m_dragWidget(new DragWidget(this))
     , m_multiScreenWorker(multiScreenWorker)
-    , m_updateDragAreaTimer(new QTimer(this))
     , m_platformWindowHandle(this)
-    , m_shadowMaskOptimizeTimer(new QTimer(this))
+    , m_commitTimer(new QTimer(this))
+    , m_shadowRadius(-1)
+    , m_shadowDirty(true)
+    , m_dockGeometryPosition(Dock::Position(-1))
+    , m_dockGeometryDisplayMode(Dock::DisplayMode(-1))
     , m_isShow(false)
     , m_borderRadius(0)
     , m_order(0)
@@ -107,23 +120,31 @@ void MainWindowBase::initAttribute()
 
 void MainWindowBase::initConnection()
 {
-    connect(DWindowManagerHelper::instance(), &DWindowManagerHelper::hasCompositeChanged, m_shadowMaskOptimizeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
-    connect(m_shadowMaskOptimizeTimer, &QTimer::timeout, this, &MainWindowBase::adjustShadowMask, Qt::QueuedConnection);
-
-    connect(&m_platformWindowHandle, &DPlatformWindowHandle::frameMarginsChanged, m_shadowMaskOptimizeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
-    connect(&m_platformWindowHandle, &DPlatformWindowHandle::windowRadiusChanged, m_shadowMaskOptimizeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_commitTimer, &QTimer::timeout, this, &MainWindowBase::commitGeometry);
+
+    auto markShadowDirty = [ this ] {
+        m_shadowDirty = true;
+        scheduleCommit(RadiusStage);
+    };
+    connect(DWindowManagerHelper::instance(), &DWindowManagerHelper::hasCompositeChanged, this, markShadowDirty);
+    connect(&m_platformWindowHandle, &DPlatformWindowHandle::frameMarginsChanged, this, markShadowDirty);
+    connect(&m_platformWindowHandle, &DPlatformWindowHandle::windowRadiusChanged, this, [ = ] {
+        // 自己设置圆角的时候也会收到这个信号，只有被其他地方修改了才需要重新设置
+        if (m_platformWindowHandle.windowRadius() != m_shadowRadius)
+            markShadowDirty();
+    });
 
     connect(m_dragWidget, &DragWidget::dragFinished, this, [ = ] {
         Utils::setIsDraging(false);
     });
 
     // -拖拽任务栏改变高度或宽度-------------------------------------------------------------------------------
-    connect(m_updateDragAreaTimer, &QTimer::timeout, this, &MainWindowBase::resetDragWindow);
-    //TODO 后端考虑删除这块，目前还不能删除，调整任务栏高度的时候，任务栏外部区域有变化
-    connect(m_updateDragAreaTimer, &QTimer::timeout, m_multiScreenWorker, &MultiScreenWorker::onRequestUpdateRegionMonitor);
-
     connect(m_dragWidget, &DragWidget::dragPointOffset, this, &MainWindowBase::onMainWindowSizeChanged);
-    connect(m_dragWidget, &DragWidget::dragFinished, this, &MainWindowBase::resetDragWindow);   //　更新拖拽区域
+    connect(m_dragWidget, &DragWidget::dragFinished, this, [ this ] {
+        // 拖拽结束时大小已经确定，不用等待位置稳定，下一帧直接通知后端
+        m_geometrySettleTimer.invalidate();
+        scheduleCommit(DragHandleStage | DockGeometryStage);
+    });
     connect(TouchSignalManager::instance(), &TouchSignalManager::touchMove, m_dragWidget, &DragWidget::onTouchMove);
     connect(TouchSignalManager::instance(), &TouchSignalManager::middleTouchPress, this, &MainWindowBase::touchRequestResizeDock);
 
@@ -136,11 +157,48 @@ void MainWindowBase::initConnection()
 
 void MainWindowBase::initMember()
 {
-    //INFO 这里要大于动画的300ms，否则可能动画过程中这个定时器就被触发了
-    m_updateDragAreaTimer->setInterval(500);
-    m_updateDragAreaTimer->setSingleShot(true);
-    m_shadowMaskOptimizeTimer->setSingleShot(true);
-    m_shadowMaskOptimizeTimer->setInterval(100);
+    m_commitTimer->setSingleShot(true);
+    m_commitTimer->setInterval(COMMIT_INTERVAL);
+}
+
+/**
+ * @brief MainWindowBase::scheduleCommit 标记需要更新的内容，在下一帧统一提交
+ * @param stages 需要更新的阶段
+ */
+void MainWindowBase::scheduleCommit(CommitStages stages)
+{
+    m_pendingStages |= stages;
+
+    // 已经安排在下一帧提交的时候不重新计时，保证拖拽过程中也是每帧提交一次，只在等待位置稳定的时候提前
+    if (!m_commitTimer->isActive() || m_commitTimer->remainingTime() > COMMIT_INTERVAL)
+        m_commitTimer->start(COMMIT_INTERVAL);
+}
+
+/**
+ * @brief MainWindowBase::commitGeometry 一次性处理窗口位置和大小变化后需要更新的内容
+ * 按照拖拽区域->圆角阴影->通知后端和窗管的顺序处理，每个阶段的输入没有变化时直接跳过
+ */
+void MainWindowBase::commitGeometry()
+{
+    const CommitStages stages = m_pendingStages;
+    m_pendingStages = CommitStages();
+
+    if (stages.testFlag(DragHandleStage))
+        commitDragHandle();
+
+    if (stages.testFlag(RadiusStage))
+        commitRadius();
+
+    if (stages.testFlag(DockGeometryStage)) {
+        // 动画过程中位置和大小一直在变化，等稳定之后再通知后端和窗管
+        const qint64 elapsed = m_geometrySettleTimer.isValid() ? m_geometrySettleTimer.elapsed() : GEOMETRY_SETTLE_TIME;
+        if (elapsed < GEOMETRY_SETTLE_TIME) {
+            m_pendingStages |= DockGeometryStage;
+            m_commitTimer->start(int(GEOMETRY_SETTLE_TIME - elapsed));
+        } else {
+            commitDockGeometry();
+        }
+    }
 }
 
 int MainWindowBase::getBorderRadius() const
@@ -246,23 +304,29 @@ void MainWindowBase::onMainWindowSizeChanged(QPoint offset)
     Q_EMIT requestUpdate();
 }
 
-void MainWindowBase::updateDragGeometry()
+void MainWindowBase::commitDragHandle()
 {
+    QRect dragRect;
     switch (position()) {
     case Dock::Top:
-        m_dragWidget->setGeometry(0, height() - DRAG_AREA_SIZE, width(), DRAG_AREA_SIZE);
+        dragRect = QRect(0, height() - DRAG_AREA_SIZE, width(), DRAG_AREA_SIZE);
         break;
     case Dock::Bottom:
-        m_dragWidget->setGeometry(0, 0, width(), DRAG_AREA_SIZE);
+        dragRect = QRect(0, 0, width(), DRAG_AREA_SIZE);
         break;
     case Dock::Left:
-        m_dragWidget->setGeometry(width() - DRAG_AREA_SIZE, 0, DRAG_AREA_SIZE, height());
+        dragRect = QRect(width() - DRAG_AREA_SIZE, 0, DRAG_AREA_SIZE, height());
         break;
     case Dock::Right:
-        m_dragWidget->setGeometry(0, 0, DRAG_AREA_SIZE, height());
+        dragRect = QRect(0, 0, DRAG_AREA_SIZE, height());
         break;
     }
 
+    if (dragRect == m_dragHandleRect)
+        return;
+
+    m_dragHandleRect = dragRect;
+    m_dragWidget->setGeometry(dragRect);
     m_dragWidget->raise();
     if ((Top == position()) || (Bottom == position())) {
         m_dragWidget->setCursor(Qt::SizeVerCursor);
@@ -271,13 +335,20 @@ void MainWindowBase::updateDragGeometry()
     }
 }
 
-void MainWindowBase::resetDragWindow()
+void MainWindowBase::commitDockGeometry()
 {
-    updateDragGeometry();
     QScreen *screen = DIS_INS->screen(DOCK_SCREEN->current());
     if (!screen)
         return;
 
+    // 和上次通知的数据相同时不需要再通知一次
+    if (geometry() == m_dockGeometry && position() == m_dockGeometryPosition && displayMode() == m_dockGeometryDisplayMode)
+        return;
+
+    m_dockGeometry = geometry();
+    m_dockGeometryPosition = position();
+    m_dockGeometryDisplayMode = displayMode();
+
     QRect currentRect = getDockGeometry(screen, position(), displayMode(), Dock::HideState::Show);
 
     // 这个时候屏幕有可能是隐藏的，不能直接使用this->width()这种去设置任务栏的高度，而应该保证原值
@@ -301,7 +372,8 @@ void MainWindowBase::resetDragWindow()
     m_multiScreenWorker->updateDaemonDockSize(dockSize);                                // 1.先更新任务栏高度
     m_multiScreenWorker->requestUpdateFrontendGeometry();                               // 2.再更新任务栏位置,保证先1再2
     m_multiScreenWorker->requestNotifyWindowManager();
-    m_multiScreenWorker->requestUpdateRegionMonitor();                                  // 界面发生变化，应更新监控区域
+    //TODO 后端考虑删除这块，目前还不能删除，调整任务栏高度的时候，任务栏外部区域有变化
+    m_multiScreenWorker->onRequestUpdateRegionMonitor();                                // 界面发生变化，应更新监控区域
 }
 
 void MainWindowBase::touchRequestResizeDock()
@@ -339,11 +411,20 @@ void MainWindowBase::touchRequestResizeDock()
                                                   , Qt::NoModifier, Qt::MouseEventSynthesizedByApplication));
 }
 
-void MainWindowBase::adjustShadowMask()
+void MainWindowBase::commitRadius()
 {
-    if (!m_isShow || m_shadowMaskOptimizeTimer->isActive())
+    const int borderRadius = getBorderRadius();
+    if (borderRadius != m_borderRadius) {
+        m_borderRadius = borderRadius;
+        updateRadius(m_borderRadius);
+    }
+
+    // 窗口圆角同时决定了模糊区域和阴影的形状
+    if (!m_isShow || (!m_shadowDirty && m_shadowRadius == m_borderRadius))
         return;
 
+    m_shadowDirty = false;
+    m_shadowRadius = m_borderRadius;
     m_platformWindowHandle.setWindowRadius(m_borderRadius);
 }
 
@@ -354,7 +435,8 @@ void MainWindowBase::onCompositeChanged()
     setMaskAlpha(m_multiScreenWorker->opacity());
     m_platformWindowHandle.setBorderWidth(0);
 
-    m_shadowMaskOptimizeTimer->start();
+    m_shadowDirty = true;
+    scheduleCommit(RadiusStage);
 }
 
 void MainWindowBase::onThemeTypeChanged(DGuiApplicationHelper::ColorType themeType)
@@ -373,7 +455,7 @@ void MainWindowBase::onThemeTypeChanged(DGuiApplicationHelper::ColorType themeTy
 void MainWindowBase::setDisplayMode(const Dock::DisplayMode &displayMode)
 {
     m_displayMode = displayMode;
-    adjustShadowMask();
+    scheduleCommit(RadiusStage);
     m_platformWindowHandle.setShadowOffset(QPoint(0, (displayMode == Dock::DisplayMode::Fashion ? 5 : 0)));
 }
 
@@ -510,6 +592,20 @@ QVariantAnimation *MainWindowBase::createAnimation(QScreen *screen, const Dock::
 #endif
     ani->setDuration(duration);
 
+    // 性能追踪打开时记录动画的帧间隔
+    const QString aniName = (act == Dock::AniAction::Show ? "dock-show" : "dock-hide");
+    connect(ani, &QVariantAnimation::valueChanged, this, [ aniName ] {
+        PerformanceTracer::instance()->recordAnimationFrame(aniName);
+    });
+
+#ifndef DISABLE_SHOW_ANIMATION
+    // 开启特效时由窗管合成透明度的变化，避免每一帧都重新设置窗口大小、重新布局和更新模糊区域
+    if (composite && !Utils::IS_WAYLAND_DISPLAY && SETTINGCONFIG->value(DOCK_ANIMATION_MODE).toString() != "geometry") {
+        setupFadeAnimation(ani, pos, act, dockShowRect, dockHideRect);
+        return ani;
+    }
+#endif
+
     connect(ani, &QVariantAnimation::valueChanged, this, [ = ](const QVariant &value) {
         if ((!m_multiScreenWorker->testState(MultiScreenWorker::ShowAnimationStart)
                 && !m_multiScreenWorker->testState(MultiScreenWorker::HideAnimationStart)
@@ -542,6 +638,40 @@ QVariantAnimation *MainWindowBase::createAnimation(QScreen *screen, const Dock::
     return ani;
 }
 
+/** 通过透明度实现显示和隐藏的动画，窗口的位置和大小在动画开始(显示)或者结束(隐藏)的时候只设置一次
+ * @brief MainWindowBase::setupFadeAnimation
+ */
+void MainWindowBase::setupFadeAnimation(QVariantAnimation *ani, const Dock::Position &pos, const Dock::AniAction &act, const QRect &showRect, const QRect &hideRect)
+{
+    ani->setStartValue(act == Dock::AniAction::Show ? 0.0 : 1.0);
+    ani->setEndValue(act == Dock::AniAction::Show ? 1.0 : 0.0);
+
+    connect(ani, &QVariantAnimation::stateChanged, this, [ = ](QAbstractAnimation::State newState) {
+        if (newState == QAbstractAnimation::Running && act == Dock::AniAction::Show) {
+            // 在动画开始的时候才设置窗口的位置，切换位置的时候显示动画要等隐藏动画结束后才开始
+            setWindowOpacity(0.0);
+            updateParentGeometry(pos, showRect);
+        } else if (newState == QAbstractAnimation::Stopped && act == Dock::AniAction::Show) {
+            // 动画被中途停止的时候也要保证任务栏完整显示
+            setWindowOpacity(1.0);
+        }
+    });
+
+    connect(ani, &QVariantAnimation::valueChanged, this, [ = ](const QVariant &value) {
+        if (ani->state() != QVariantAnimation::State::Running)
+            return;
+
+        setWindowOpacity(value.toReal());
+    });
+
+    connect(ani, &QVariantAnimation::finished, this, [ = ] {
+        if (act == Dock::AniAction::Hide)
+            updateParentGeometry(pos, hideRect);
+
+        setWindowOpacity(1.0);
+    });
+}
+
 Dock::DisplayMode MainWindowBase::displayMode() const
 {
     return m_displayMode;
@@ -583,26 +713,26 @@ void MainWindowBase::initUi()
 
 void MainWindowBase::resizeEvent(QResizeEvent *event)
 {
-    updateDragGeometry();
+    Q_UNUSED(event);
 
-    int borderRadius = getBorderRadius();
-    if (borderRadius != m_borderRadius) {
-        m_borderRadius = borderRadius;
-        updateRadius(m_borderRadius);
+    CommitStages stages = DragHandleStage | RadiusStage;
+    if (!isDraging()) {
+        m_geometrySettleTimer.restart();
+        stages |= DockGeometryStage;
     }
 
-    m_shadowMaskOptimizeTimer->start();
-
-    if (!isDraging())
-        m_updateDragAreaTimer->start();
+    scheduleCommit(stages);
 }
 
 void MainWindowBase::moveEvent(QMoveEvent *)
 {
-    updateDragGeometry();
+    CommitStages stages = DragHandleStage;
+    if (!isDraging()) {
+        m_geometrySettleTimer.restart();
+        stages |= DockGeometryStage;
+    }
 
-    if (!isDraging())
-        m_updateDragAreaTimer->start();
+    scheduleCommit(stages);
 }
 
 void MainWindowBase::enterEvent(QEvent *e)
@@ -629,7 +759,7 @@ void MainWindowBase::showEvent(QShowEvent *event)
 {
     if (!m_isShow) {
         m_isShow = true;
-        m_shadowMaskOptimizeTimer->start();
+        scheduleCommit(RadiusStage);
     }
 
     DBlurEffectWidget::showEvent(event);
@@ -15,6 +15,7 @@
 
 #include <QEvent>
 #include <QMouseEvent>
+#include <QElapsedTimer>
 #include <utils.h>
 
 class DragWidget;
@@ -32,6 +33,14 @@ public:
         TrayWindow      // 主窗口之外的其他窗口
     };
 
+    // 窗口位置和大小变化后需要同步更新的内容，统一在commitGeometry中每帧最多处理一次
+    enum CommitStage {
+        DragHandleStage = 0x1,          // 调整任务栏大小的拖拽区域
+        RadiusStage = 0x2,              // 圆角、模糊区域和阴影
+        DockGeometryStage = 0x4,        // 通知后端和窗管(struts)，更新唤起区域
+    };
+    Q_DECLARE_FLAGS(CommitStages, CommitStage)
+
 public:
     explicit MainWindowBase(MultiScreenWorker *multiScreenWorker, QWidget *parent = Q_NULLPTR);
     virtual ~MainWindowBase();
@@ -76,16 +85,19 @@ private:
     void initAttribute();
     void initConnection();
     void initMember();
-    void updateDragGeometry();
+    void scheduleCommit(CommitStages stages);
+    void commitDragHandle();
+    void commitRadius();
+    void commitDockGeometry();
 
     int getBorderRadius() const;
     QRect getAnimationRect(const QRect &sourceRect, const Dock::Position &pos) const;
+    void setupFadeAnimation(QVariantAnimation *ani, const Dock::Position &pos, const Dock::AniAction &act, const QRect &showRect, const QRect &hideRect);
 
 private Q_SLOTS:
     void onMainWindowSizeChanged(QPoint offset);
-    void resetDragWindow();
+    void commitGeometry();
     void touchRequestResizeDock();
-    void adjustShadowMask();
     void onCompositeChanged();
     void onThemeTypeChanged(DGuiApplicationHelper::ColorType themeType);
 
@@ -94,12 +106,21 @@ private:
     Dock::Position m_position;
     DragWidget *m_dragWidget;
     MultiScreenWorker *m_multiScreenWorker;
-    QTimer *m_updateDragAreaTimer;
     DPlatformWindowHandle m_platformWindowHandle;
-    QTimer *m_shadowMaskOptimizeTimer;
+    QTimer *m_commitTimer;
+    CommitStages m_pendingStages;
+    QElapsedTimer m_geometrySettleTimer;        // 距离上次位置或大小变化的时间，动画过程中不通知后端
+    QRect m_dragHandleRect;                     // 已经提交的数据，和这些数据相同时跳过对应的阶段
+    int m_shadowRadius;
+    bool m_shadowDirty;                         // 特效或者窗口边距变化后需要重新设置圆角
+    QRect m_dockGeometry;
+    Dock::Position m_dockGeometryPosition;
+    Dock::DisplayMode m_dockGeometryDisplayMode;
     bool m_isShow;
     int m_borderRadius;
     int m_order;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(MainWindowBase::CommitStages)
+
 #endif // MAINWINDOWBASE_H
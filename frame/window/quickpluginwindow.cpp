@@ -33,11 +33,13 @@
 typedef struct DragInfo{
     QPoint dragPoint;
     QuickDockItem *dockItem = nullptr;
+    mutable QPixmap pixmap;         // 判断是否可以拖拽和开始拖拽时都需要这张图片，只生成一次
 
     void reset() {
         dockItem = nullptr;
         dragPoint.setX(0);
         dragPoint.setY(0);
+        pixmap = QPixmap();
     }
 
     bool isNull() const {
@@ -59,7 +61,10 @@ typedef struct DragInfo{
         if (!dockItem)
             return QPixmap();
 
-        QPixmap pixmap = dockItem->pluginItem()->icon(DockPart::QuickShow).pixmap(QSize(ITEMSIZE, ITEMSIZE));
+        if (!pixmap.isNull())
+            return pixmap;
+
+        pixmap = dockItem->pluginItem()->icon(DockPart::QuickShow).pixmap(QSize(ITEMSIZE, ITEMSIZE));
         if (!pixmap.isNull())
             return pixmap;
 
@@ -68,7 +73,8 @@ typedef struct DragInfo{
         if (!itemWidget)
             return QPixmap();
 
-        return itemWidget->grab();
+        pixmap = itemWidget->grab();
+        return pixmap;
     }
 } DragInfo;
 
@@ -257,6 +263,7 @@ bool QuickPluginWindow::eventFilter(QObject *watched, QEvent *event)
         if (!dockItem)
             break;
 
+        m_dragInfo->reset();
         m_dragInfo->dockItem = dockItem;
         m_dragInfo->dragPoint = mouseEvent->pos();
         break;
@@ -471,7 +478,7 @@ void QuickPluginWindow::startDrag()
     QPixmap dragPixmap = m_dragInfo->dragPixmap();
     drag->setPixmap(dragPixmap);
 
-    drag->setHotSpot(dragPixmap.rect().center());
+    drag->setHotSpot(dragPixmap.rect().center() / dragPixmap.devicePixelRatioF());
 
     drag->exec(Qt::CopyAction);
     // 获取当前鼠标在任务栏快捷图标区域的位置
@@ -6,6 +6,8 @@
 #ifndef DBUSTRAYMANAGER_H_1467094672
 #define DBUSTRAYMANAGER_H_1467094672
 
+#include "dbustracer.h"
+
 #include <QtCore/QObject>
 #include <QtCore/QByteArray>
 #include <QtCore/QList>
@@ -20,7 +22,7 @@ typedef QList<quint32> TrayList;
 /*
  * Proxy class for interface org.deepin.dde.TrayManager1
  */
-class DBusTrayManager: public QDBusAbstractInterface
+class DBusTrayManager: public DBusTracedInterface
 {
     Q_OBJECT
 
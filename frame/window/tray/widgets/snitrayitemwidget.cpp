@@ -23,6 +23,10 @@
 DGUI_USE_NAMESPACE
 
 #define IconSize 20
+#define MENU_STALE_BUDGET_MIN (5 * 1000)         // 缓存的菜单超过这个时间没有更新过，鼠标移入时重新获取
+#define MENU_STALE_BUDGET_MAX (60 * 1000)
+#define MENU_STALE_BUDGET_FACTOR 20             // 响应越慢的程序缓存的时间越长
+#define MENU_REQUEST_TIMEOUT (25 * 1000)        // 和DBus调用默认的超时时间一致，超过这个时间认为获取菜单失败
 
 const QStringList ItemCategoryList {"ApplicationStatus", "Communications", "SystemServices", "Hardware"};
 const QStringList ItemStatusList {"Passive", "Active", "NeedsAttention"};
@@ -33,6 +37,7 @@ using namespace Dock;
 
 SNITrayItemWidget::SNITrayItemWidget(const QString &sniServicePath, QWidget *parent)
     : BaseTrayWidget(parent),
+      m_dbusMenuImporter(nullptr),
       m_menu(nullptr),
       m_updateIconTimer(new QTimer(this))
     , m_updateOverlayIconTimer(new QTimer(this))
@@ -42,6 +47,8 @@ SNITrayItemWidget::SNITrayItemWidget(const QString &sniServicePath, QWidget *par
     , m_handleMouseReleaseTimer(new QTimer(this))
     , m_tipsLabel(new TipsWidget)
     , m_popupShown(false)
+    , m_menuUpdating(false)
+    , m_menuStaleBudget(MENU_STALE_BUDGET_MIN)
 {
     m_popupTipsDelayTimer->setInterval(500);
     m_popupTipsDelayTimer->setSingleShot(true);
@@ -253,7 +260,15 @@ void SNITrayItemWidget::initMenu()
 
     qDebug() << "using sni service path:" << m_dbusService << "menu path:" << sniMenuPath;
 
+    // 创建的时候会异步获取一次菜单的布局
     m_dbusMenuImporter = new DBusMenuImporter(m_dbusService, sniMenuPath, ASYNCHRONOUS, this);
+    m_menuRequestTime.start();
+    m_menuUpdating = true;
+    connect(m_dbusMenuImporter, static_cast<void (DBusMenuImporter::*)()>(&DBusMenuImporter::menuUpdated), this, &SNITrayItemWidget::onMenuUpdated);
+
+    // 程序主动通知菜单变化时，DBusMenuImporter会自己重新获取，缓存仍然是最新的
+    QDBusConnection::sessionBus().connect(m_dbusService, sniMenuPath, "com.canonical.dbusmenu", "LayoutUpdated",
+                                          this, SLOT(onMenuLayoutUpdated()));
 
     qDebug() << "generate the sni menu object";
 
@@ -262,6 +277,63 @@ void SNITrayItemWidget::initMenu()
     qDebug() << "the sni menu obect is:" << m_menu;
 }
 
+/**
+ * @brief SNITrayItemWidget::prefetchMenu 鼠标移入时提前获取菜单，右键时直接显示缓存的菜单
+ * 菜单超过缓存时间没有更新过才重新获取，缓存时间按照程序上一次的响应时间计算
+ */
+void SNITrayItemWidget::prefetchMenu()
+{
+    if (m_sniMenuPath.path().isEmpty() || m_sniMenuPath.path().startsWith("/NO_DBUSMENU"))
+        return;
+
+    if (!m_menu) {
+        initMenu();
+        return;
+    }
+
+    // 获取菜单失败时DBusMenuImporter不会发出menuUpdated，超时后允许重新获取
+    if (m_menuUpdating && m_menuRequestTime.elapsed() > MENU_REQUEST_TIMEOUT)
+        m_menuUpdating = false;
+
+    if (m_menuUpdating || (m_menuValidTime.isValid() && m_menuValidTime.elapsed() < m_menuStaleBudget))
+        return;
+
+    m_menuRequestTime.start();
+    m_menuUpdating = true;
+    m_dbusMenuImporter->updateMenu();
+}
+
+void SNITrayItemWidget::onMenuUpdated()
+{
+    if (m_menuUpdating && m_menuRequestTime.isValid()) {
+        const qint64 latency = m_menuRequestTime.elapsed();
+        m_menuStaleBudget = qBound<qint64>(MENU_STALE_BUDGET_MIN, latency * MENU_STALE_BUDGET_FACTOR, MENU_STALE_BUDGET_MAX);
+    }
+
+    m_menuUpdating = false;
+    m_menuValidTime.start();
+}
+
+void SNITrayItemWidget::onMenuLayoutUpdated()
+{
+    m_menuValidTime.start();
+}
+
+void SNITrayItemWidget::resetMenu()
+{
+    if (!m_dbusMenuImporter)
+        return;
+
+    QDBusConnection::sessionBus().disconnect(m_dbusService, m_sniMenuPath.path(), "com.canonical.dbusmenu",
+                                             "LayoutUpdated", this, SLOT(onMenuLayoutUpdated()));
+    // 菜单由DBusMenuImporter管理，随着它一起释放
+    m_dbusMenuImporter->deleteLater();
+    m_dbusMenuImporter = nullptr;
+    m_menu = nullptr;
+    m_menuUpdating = false;
+    m_menuValidTime.invalidate();
+}
+
 void SNITrayItemWidget::refreshIcon()
 {
     QPixmap pix = newIconPixmap(Icon);
@@ -384,6 +456,11 @@ void SNITrayItemWidget::onSNIIdChanged(const QString &value)
 
 void SNITrayItemWidget::onSNIMenuChanged(const QDBusObjectPath &value)
 {
+    if (m_sniMenuPath == value)
+        return;
+
+    // 菜单的路径变化后缓存的菜单已经失效
+    resetMenu();
     m_sniMenuPath = value;
 }
 
@@ -547,6 +624,8 @@ void SNITrayItemWidget::enterEvent(QEvent *event)
         m_popupTipsDelayTimer->start();
     }
 
+    prefetchMenu();
+
     BaseTrayWidget::enterEvent(event);
 }
 
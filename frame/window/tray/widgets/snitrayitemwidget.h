@@ -13,6 +13,7 @@
 #include "org_kde_statusnotifieritem.h"
 
 #include <QMenu>
+#include <QElapsedTimer>
 #include <QDBusObjectPath>
 
 class DBusMenuImporter;
@@ -66,6 +67,9 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void initMenu();
+    void prefetchMenu();
+    void onMenuUpdated();
+    void onMenuLayoutUpdated();
     void refreshIcon();
     void refreshOverlayIcon();
     void refreshAttentionIcon();
@@ -97,6 +101,7 @@ private:
     void setMouseData(QMouseEvent *e);
     void handleMouseRelease();
     void initMember();
+    void resetMenu();
 
 private:
     StatusNotifierItem *m_sniInter;
@@ -135,6 +140,11 @@ private:
     static QPointer<DockPopupWindow> PopupWindow;
     Dock::TipsWidget *m_tipsLabel;
     bool m_popupShown;
+
+    bool m_menuUpdating;
+    QElapsedTimer m_menuRequestTime;
+    QElapsedTimer m_menuValidTime;                      // 菜单最近一次更新的时间
+    qint64 m_menuStaleBudget;                           // 菜单的缓存时间
 };
 
 #endif /* SNIWIDGET_H */
@@ -6,6 +6,7 @@
 #include "constants.h"
 #include "xembedtrayitemwidget.h"
 #include "platformutils.h"
+#include "x11atoms.h"
 //#include "utils.h"
 
 #include <QWindow>
@@ -232,10 +233,7 @@ void XEmbedTrayItemWidget::wrapWindow()
         QWindow * win = QWindow::fromWinId(m_containerWid);
         win->setOpacity(0);
     } else {
-        const char* opacityName = "_NET_WM_WINDOW_OPACITY\0";
-        xcb_intern_atom_cookie_t opacityCookie = xcb_intern_atom(c, false, strlen(opacityName), opacityName);
-        xcb_intern_atom_reply_t *opacityReply = xcb_intern_atom_reply(c, opacityCookie, 0);
-        xcb_atom_t opacityAtom = opacityReply->atom;
+        xcb_atom_t opacityAtom = X11Atoms::instance()->atom(X11Atoms::NET_WM_WINDOW_OPACITY);
         quint32 opacity = 10;
         xcb_change_property(c,
                            XCB_PROP_MODE_REPLACE,
@@ -531,7 +529,7 @@ uint XEmbedTrayItemWidget::getWindowPID(uint winId)
         return 0;
     }
 
-    Atom nameAtom = XInternAtom(display, "_NET_WM_PID", 1);
+    const Atom nameAtom = X11Atoms::instance()->atom(X11Atoms::NET_WM_PID);
     Atom type;
     int format, status;
 
@@ -540,7 +538,7 @@ uint XEmbedTrayItemWidget::getWindowPID(uint winId)
     unsigned int pid = 0;
 
     status = XGetWindowProperty(display, winId, nameAtom, 0, 1024, 0,
-            XInternAtom(display, "CARDINAL", 0), &type, &format, &nitems, &after, &data);
+            X11Atoms::instance()->atom(X11Atoms::CARDINAL), &type, &format, &nitems, &after, &data);
     if (status == Success && data) {
         pid = *((uint*)data);
         XFree(data);
@@ -15,6 +15,12 @@ namespace Dock {
 
 #define PROP_DISPLAY_MODE   "DisplayMode"
 #define PROP_DOCK_DRAGING   "isDraging"
+// 插件配置批量写入的统计信息(json)，由插件管理器更新，通过任务栏的DBus接口获取
+#define PROP_PLUGIN_SETTINGS_STATISTICS "pluginSettingsStatistics"
+// 任务栏和插件共用的DBusTracer实例
+#define PROP_DBUS_TRACER    "dbusTracer"
+// 任务栏和插件共用的PerformanceTracer实例
+#define PROP_PERFORMANCE_TRACER "performanceTracer"
 
 #define PLUGIN_BACKGROUND_MAX_SIZE 40
 #define PLUGIN_BACKGROUND_MIN_SIZE 20
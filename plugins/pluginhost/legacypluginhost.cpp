@@ -0,0 +1,424 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "legacypluginhost.h"
+#include "pluginsiteminterface_v20.h"
+
+#include <QApplication>
+#include <QLocalSocket>
+#include <QPluginLoader>
+#include <QSharedMemory>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#define RENDER_INTERVAL 16              // 画面合并刷新的间隔，一帧
+#define GET_VALUE_TIMEOUT 500           // 等待任务栏返回配置的最长时间
+
+using namespace PluginHost;
+
+LegacyPluginHost::LegacyPluginHost(const QString &socketName, const QString &pluginFile, QObject *parent)
+    : QObject(parent)
+    , m_socketName(socketName)
+    , m_pluginFile(pluginFile)
+    , m_socket(new QLocalSocket(this))
+    , m_pluginLoader(new QPluginLoader(pluginFile, this))
+    , m_pluginInter(nullptr)
+    , m_valueSerial(0)
+    , m_waitingValue(false)
+    , m_renderTimer(new QTimer(this))
+    , m_rendering(false)
+    , m_sharedMemorySerial(0)
+{
+    m_renderTimer->setSingleShot(true);
+    m_renderTimer->setInterval(RENDER_INTERVAL);
+
+    connect(m_renderTimer, &QTimer::timeout, this, &LegacyPluginHost::renderDirtyItems);
+    connect(m_socket, &QLocalSocket::readyRead, this, &LegacyPluginHost::onReadyRead);
+    connect(m_socket, &QLocalSocket::disconnected, this, &LegacyPluginHost::onDisconnected);
+}
+
+LegacyPluginHost::~LegacyPluginHost()
+{
+    qDeleteAll(m_sharedMemories);
+}
+
+bool LegacyPluginHost::start()
+{
+    m_socket->connectToServer(m_socketName);
+    if (!m_socket->waitForConnected(3000)) {
+        qWarning() << "connect to dock failed:" << m_socketName << m_socket->errorString();
+        return false;
+    }
+
+    m_pluginInter = qobject_cast<PluginsItemInterface_V20 *>(m_pluginLoader->instance());
+    if (!m_pluginInter) {
+        qWarning() << "load plugin failed:" << m_pluginFile << m_pluginLoader->errorString();
+        return false;
+    }
+
+    send(Hello, { m_pluginInter->pluginName(), m_pluginInter->pluginDisplayName(), int(m_pluginInter->type()),
+                  int(m_pluginInter->pluginSizePolicy()), m_pluginInter->pluginIsAllowDisable(), m_pluginInter->pluginIsDisable() });
+
+    // 插件窗口在本进程中都是顶层窗口，通过监听绘制事件来得知插件窗口需要刷新
+    qApp->installEventFilter(this);
+
+    m_pluginInter->init(this);
+    return true;
+}
+
+bool LegacyPluginHost::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint && !m_rendering && watched->isWidgetType()) {
+        QWidget *window = static_cast<QWidget *>(watched)->window();
+        if (m_itemWindows.contains(window))
+            scheduleRender(m_itemWindows.value(window));
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void LegacyPluginHost::itemAdded(PluginsItemInterface * const itemInter, const QString &itemKey)
+{
+    Q_UNUSED(itemInter);
+
+    QWidget *widget = m_pluginInter->itemWidget(itemKey);
+    if (widget) {
+        m_itemWindows[widget] = itemKey;
+        widget->show();
+    }
+
+    send(ItemAdded, { itemKey, m_pluginInter->itemSortKey(itemKey), m_pluginInter->itemAllowContainer(itemKey),
+                      m_pluginInter->itemIsInContainer(itemKey), m_pluginInter->itemCommand(itemKey),
+                      m_pluginInter->itemTipsWidget(itemKey) != nullptr });
+    send(ContextMenu, { itemKey, m_pluginInter->itemContextMenu(itemKey) });
+}
+
+void LegacyPluginHost::itemUpdate(PluginsItemInterface * const itemInter, const QString &itemKey)
+{
+    Q_UNUSED(itemInter);
+
+    scheduleRender(itemKey);
+    send(ItemUpdate, { itemKey });
+}
+
+void LegacyPluginHost::itemRemoved(PluginsItemInterface * const itemInter, const QString &itemKey)
+{
+    Q_UNUSED(itemInter);
+
+    QWidget *widget = m_itemWindows.key(itemKey);
+    if (widget) {
+        m_itemWindows.remove(widget);
+        widget->hide();
+    }
+
+    m_dirtyItems.remove(itemKey);
+    send(ItemRemoved, { itemKey });
+}
+
+void LegacyPluginHost::requestWindowAutoHide(PluginsItemInterface * const itemInter, const QString &itemKey, const bool autoHide)
+{
+    Q_UNUSED(itemInter);
+    send(RequestAutoHide, { itemKey, autoHide });
+}
+
+void LegacyPluginHost::requestRefreshWindowVisible(PluginsItemInterface * const itemInter, const QString &itemKey)
+{
+    Q_UNUSED(itemInter);
+    send(RequestRefreshVisible, { itemKey });
+}
+
+void LegacyPluginHost::requestSetAppletVisible(PluginsItemInterface * const itemInter, const QString &itemKey, const bool visible)
+{
+    // 独立进程中的插件不支持弹出面板
+    Q_UNUSED(itemInter);
+    Q_UNUSED(itemKey);
+    Q_UNUSED(visible);
+}
+
+void LegacyPluginHost::saveValue(PluginsItemInterface * const itemInter, const QString &key, const QVariant &value)
+{
+    Q_UNUSED(itemInter);
+    send(SaveValue, { key, value });
+}
+
+const QVariant LegacyPluginHost::getValue(PluginsItemInterface * const itemInter, const QString &key, const QVariant &fallback)
+{
+    Q_UNUSED(itemInter);
+
+    // 配置保存在任务栏进程中，这里同步等待任务栏的返回，期间收到的其他消息稍后再处理
+    const quint32 serial = ++m_valueSerial;
+    send(GetValue, { serial, key, fallback });
+
+    QVariant value = fallback;
+    bool replied = false;
+    m_waitingValue = true;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!replied && timer.elapsed() < GET_VALUE_TIMEOUT) {
+        MessageType type;
+        QVariantList args;
+        while (!replied && decode(m_readBuffer, type, args)) {
+            if (type == ValueReply && args.value(0).toUInt() == serial) {
+                value = args.value(1);
+                replied = true;
+            } else {
+                m_pendingMessages << qMakePair(type, args);
+            }
+            args.clear();
+        }
+
+        if (replied || !m_socket->waitForReadyRead(GET_VALUE_TIMEOUT - timer.elapsed()))
+            break;
+
+        m_readBuffer.append(m_socket->readAll());
+    }
+
+    m_waitingValue = false;
+    if (!replied)
+        qWarning() << "get value from dock timeout:" << key;
+
+    if (!m_pendingMessages.isEmpty() || !m_readBuffer.isEmpty())
+        QTimer::singleShot(0, this, &LegacyPluginHost::processPendingMessages);
+
+    return value;
+}
+
+void LegacyPluginHost::removeValue(PluginsItemInterface * const itemInter, const QStringList &keyList)
+{
+    Q_UNUSED(itemInter);
+    send(RemoveValue, { keyList });
+}
+
+void LegacyPluginHost::onReadyRead()
+{
+    // getValue中会自己读取数据
+    if (m_waitingValue)
+        return;
+
+    m_readBuffer.append(m_socket->readAll());
+    processPendingMessages();
+}
+
+void LegacyPluginHost::onDisconnected()
+{
+    // 任务栏已经退出或者主动断开，插件进程也随之退出
+    qApp->quit();
+}
+
+void LegacyPluginHost::renderDirtyItems()
+{
+    const QSet<QString> dirtyItems = m_dirtyItems;
+    m_dirtyItems.clear();
+
+    for (const QString &itemKey : dirtyItems) {
+        QWidget *widget = m_itemWindows.key(itemKey);
+        if (widget)
+            renderFrame(ItemRole, itemKey, widget, m_devicePixelRatios.value(itemKey, qApp->devicePixelRatio()));
+    }
+}
+
+void LegacyPluginHost::processPendingMessages()
+{
+    // 先处理在getValue中积压的消息，保证消息的顺序
+    while (!m_pendingMessages.isEmpty()) {
+        const QPair<MessageType, QVariantList> message = m_pendingMessages.takeFirst();
+        handleMessage(message.first, message.second);
+    }
+
+    MessageType type;
+    QVariantList args;
+    while (decode(m_readBuffer, type, args)) {
+        handleMessage(type, args);
+        args.clear();
+    }
+}
+
+void LegacyPluginHost::send(MessageType type, const QVariantList &args)
+{
+    if (m_socket->state() != QLocalSocket::ConnectedState)
+        return;
+
+    m_socket->write(encode(type, args));
+    m_socket->flush();
+}
+
+void LegacyPluginHost::handleMessage(MessageType type, const QVariantList &args)
+{
+    const QString itemKey = args.value(0).toString();
+
+    switch (type) {
+    case Resize: {
+        QWidget *widget = m_itemWindows.key(itemKey);
+        if (!widget)
+            break;
+        m_devicePixelRatios[itemKey] = args.value(2).toReal();
+        widget->resize(args.value(1).toSize());
+        scheduleRender(itemKey);
+        break;
+    }
+    case MouseEvent:
+        sendMouseEvent(itemKey, args);
+        break;
+    case WheelEvent:
+        sendWheelEvent(itemKey, args);
+        break;
+    case HoverEvent: {
+        QWidget *widget = m_itemWindows.key(itemKey);
+        if (!widget)
+            break;
+        if (args.value(1).toBool()) {
+            QEnterEvent enterEvent(QPointF(), QPointF(), QPointF());
+            QApplication::sendEvent(widget, &enterEvent);
+        } else {
+            QEvent leaveEvent(QEvent::Leave);
+            QApplication::sendEvent(widget, &leaveEvent);
+        }
+        break;
+    }
+    case RequestContextMenu:
+        send(ContextMenu, { itemKey, m_pluginInter->itemContextMenu(itemKey) });
+        break;
+    case RequestTips: {
+        QWidget *tipsWidget = m_pluginInter->itemTipsWidget(itemKey);
+        if (!tipsWidget)
+            break;
+        tipsWidget->adjustSize();
+        renderFrame(TipsRole, itemKey, tipsWidget, args.value(1).toReal());
+        break;
+    }
+    case InvokeMenuItem:
+        m_pluginInter->invokedMenuItem(itemKey, args.value(1).toString(), args.value(2).toBool());
+        break;
+    case SetSortKey:
+        m_pluginInter->setSortKey(itemKey, args.value(1).toInt());
+        break;
+    case SetItemIsInContainer:
+        m_pluginInter->setItemIsInContainer(itemKey, args.value(1).toBool());
+        break;
+    case RefreshIcon:
+        m_pluginInter->refreshIcon(itemKey);
+        break;
+    case DisplayModeChanged: {
+        const Dock::DisplayMode displayMode = static_cast<Dock::DisplayMode>(args.value(0).toInt());
+        qApp->setProperty(PROP_DISPLAY_MODE, QVariant::fromValue(displayMode));
+        m_pluginInter->displayModeChanged(displayMode);
+        break;
+    }
+    case PositionChanged: {
+        const Dock::Position position = static_cast<Dock::Position>(args.value(0).toInt());
+        qApp->setProperty(PROP_POSITION, QVariant::fromValue(position));
+        m_pluginInter->positionChanged(position);
+        break;
+    }
+    case PluginSettingsChanged:
+        m_pluginInter->pluginSettingsChanged();
+        break;
+    case PluginStateSwitched:
+        m_pluginInter->pluginStateSwitched();
+        break;
+    case Ping:
+        send(Pong, { args.value(0) });
+        break;
+    case ValueReply:
+        // getValue已经超时返回的回复，直接丢弃
+        break;
+    default:
+        qWarning() << "unknown message from dock:" << type;
+        break;
+    }
+}
+
+void LegacyPluginHost::sendMouseEvent(const QString &itemKey, const QVariantList &args)
+{
+    QWidget *widget = m_itemWindows.key(itemKey);
+    if (!widget || args.size() < 6)
+        return;
+
+    const QEvent::Type eventType = static_cast<QEvent::Type>(args[1].toInt());
+    const QPointF pos = args[2].toPointF();
+
+    // 和真实的鼠标事件一样发送给鼠标下方的子控件
+    QWidget *target = widget->childAt(pos.toPoint());
+    if (!target)
+        target = widget;
+
+    const QPointF localPos = target->mapFrom(widget, pos.toPoint());
+    QMouseEvent mouseEvent(eventType, localPos, localPos, widget->mapToGlobal(pos.toPoint()),
+                           static_cast<Qt::MouseButton>(args[3].toInt()),
+                           static_cast<Qt::MouseButtons>(args[4].toInt()),
+                           static_cast<Qt::KeyboardModifiers>(args[5].toInt()));
+    QApplication::sendEvent(target, &mouseEvent);
+
+    // 点击后插件的命令可能会发生变化
+    if (eventType == QEvent::MouseButtonRelease)
+        send(ItemCommand, { itemKey, m_pluginInter->itemCommand(itemKey) });
+}
+
+void LegacyPluginHost::sendWheelEvent(const QString &itemKey, const QVariantList &args)
+{
+    QWidget *widget = m_itemWindows.key(itemKey);
+    if (!widget || args.size() < 5)
+        return;
+
+    const QPointF pos = args[1].toPointF();
+    QWheelEvent wheelEvent(pos, widget->mapToGlobal(pos.toPoint()), QPoint(), args[2].toPoint(),
+                           static_cast<Qt::MouseButtons>(args[3].toInt()),
+                           static_cast<Qt::KeyboardModifiers>(args[4].toInt()),
+                           Qt::NoScrollPhase, false);
+    QApplication::sendEvent(widget, &wheelEvent);
+}
+
+void LegacyPluginHost::scheduleRender(const QString &itemKey)
+{
+    m_dirtyItems.insert(itemKey);
+    if (!m_renderTimer->isActive())
+        m_renderTimer->start();
+}
+
+void LegacyPluginHost::renderFrame(FrameRole role, const QString &itemKey, QWidget *widget, qreal devicePixelRatio)
+{
+    const QSize pixelSize = widget->size() * devicePixelRatio;
+    if (pixelSize.isEmpty())
+        return;
+
+    const int bytesPerLine = pixelSize.width() * 4;
+    const int byteCount = bytesPerLine * pixelSize.height();
+
+    // 画面变大时重新申请一块共享内存，使用新的key，任务栏发现key变化后会重新attach
+    const QString memoryKey = QString("%1/%2").arg(role).arg(itemKey);
+    QSharedMemory *sharedMemory = m_sharedMemories.value(memoryKey);
+    if (!sharedMemory || sharedMemory->size() < byteCount) {
+        delete sharedMemory;
+        sharedMemory = new QSharedMemory(QString("%1-%2").arg(m_socketName).arg(++m_sharedMemorySerial));
+        m_sharedMemories[memoryKey] = sharedMemory;
+        if (!sharedMemory->create(byteCount)) {
+            qWarning() << "create shared memory failed:" << sharedMemory->errorString();
+            m_sharedMemories.remove(memoryKey);
+            delete sharedMemory;
+            return;
+        }
+    }
+
+    if (!sharedMemory->lock())
+        return;
+
+    QImage image(static_cast<uchar *>(sharedMemory->data()), pixelSize.width(), pixelSize.height(),
+                 bytesPerLine, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::transparent);
+
+    m_rendering = true;
+    widget->render(&image, QPoint(), QRegion(), QWidget::DrawChildren);
+    m_rendering = false;
+
+    sharedMemory->unlock();
+
+    send(Frame, { int(role), itemKey, sharedMemory->key(), pixelSize, bytesPerLine, devicePixelRatio, widget->sizeHint() });
+}
@@ -0,0 +1,90 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef LEGACYPLUGINHOST_H
+#define LEGACYPLUGINHOST_H
+
+#include "pluginproxyinterface.h"
+#include "pluginhostprotocol.h"
+
+#include <QObject>
+#include <QMap>
+#include <QSet>
+
+class PluginsItemInterface_V20;
+class QLocalSocket;
+class QPluginLoader;
+class QSharedMemory;
+class QTimer;
+
+/** 在独立进程中加载v20插件
+ * @brief The LegacyPluginHost class
+ * 插件窗口在offscreen平台上渲染到共享内存中，由任务栏中的RemotePluginAdapter显示，
+ * 任务栏转发过来的输入事件在这里还原后发送给插件窗口
+ */
+
+class LegacyPluginHost : public QObject, public PluginProxyInterface
+{
+    Q_OBJECT
+
+public:
+    LegacyPluginHost(const QString &socketName, const QString &pluginFile, QObject *parent = nullptr);
+    ~LegacyPluginHost() override;
+
+    bool start();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    // implements PluginProxyInterface
+    void itemAdded(PluginsItemInterface * const itemInter, const QString &itemKey) override;
+    void itemUpdate(PluginsItemInterface * const itemInter, const QString &itemKey) override;
+    void itemRemoved(PluginsItemInterface * const itemInter, const QString &itemKey) override;
+    void requestWindowAutoHide(PluginsItemInterface * const itemInter, const QString &itemKey, const bool autoHide) override;
+    void requestRefreshWindowVisible(PluginsItemInterface * const itemInter, const QString &itemKey) override;
+    void requestSetAppletVisible(PluginsItemInterface * const itemInter, const QString &itemKey, const bool visible) override;
+    void saveValue(PluginsItemInterface * const itemInter, const QString &key, const QVariant &value) override;
+    const QVariant getValue(PluginsItemInterface *const itemInter, const QString &key, const QVariant& fallback = QVariant()) override;
+    void removeValue(PluginsItemInterface *const itemInter, const QStringList &keyList) override;
+
+private Q_SLOTS:
+    void onReadyRead();
+    void onDisconnected();
+    void renderDirtyItems();
+    void processPendingMessages();
+
+private:
+    void send(PluginHost::MessageType type, const QVariantList &args = QVariantList());
+    void readMessages();
+    void handleMessage(PluginHost::MessageType type, const QVariantList &args);
+    void sendMouseEvent(const QString &itemKey, const QVariantList &args);
+    void sendWheelEvent(const QString &itemKey, const QVariantList &args);
+    void scheduleRender(const QString &itemKey);
+    void renderFrame(PluginHost::FrameRole role, const QString &itemKey, QWidget *widget, qreal devicePixelRatio);
+
+private:
+    QString m_socketName;
+    QString m_pluginFile;
+    QLocalSocket *m_socket;
+    QPluginLoader *m_pluginLoader;
+    PluginsItemInterface_V20 *m_pluginInter;
+
+    QByteArray m_readBuffer;
+    QList<QPair<PluginHost::MessageType, QVariantList>> m_pendingMessages;
+    quint32 m_valueSerial;
+    bool m_waitingValue;
+
+    QMap<QString, qreal> m_devicePixelRatios;
+    QMap<QWidget *, QString> m_itemWindows;
+    QSet<QString> m_dirtyItems;
+    QTimer *m_renderTimer;
+    bool m_rendering;
+
+    QMap<QString, QSharedMemory *> m_sharedMemories;
+    quint32 m_sharedMemorySerial;
+};
+
+#endif // LEGACYPLUGINHOST_H
@@ -0,0 +1,53 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "legacypluginhost.h"
+#include "constants.h"
+
+#include <DApplication>
+#include <DLog>
+
+#include <QCommandLineParser>
+
+DWIDGET_USE_NAMESPACE
+#ifdef DCORE_NAMESPACE
+DCORE_USE_NAMESPACE
+#else
+DUTIL_USE_NAMESPACE
+#endif
+
+int main(int argc, char *argv[])
+{
+    // 插件窗口不在屏幕上显示，渲染后通过共享内存交给任务栏
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    DApplication app(argc, argv);
+    app.setOrganizationName("deepin");
+    app.setApplicationName("dde-dock-plugin-host");
+    app.setQuitOnLastWindowClosed(false);
+
+    DLogManager::registerConsoleAppender();
+
+    QCommandLineParser parser;
+    QCommandLineOption socketOption("socket", "local socket name of the dock", "name");
+    QCommandLineOption pluginOption("plugin", "the v20 plugin file to load", "file");
+    QCommandLineOption displayModeOption("display-mode", "current dock display mode", "mode", "0");
+    QCommandLineOption positionOption("position", "current dock position", "position", "2");
+    parser.addOptions({ socketOption, pluginOption, displayModeOption, positionOption });
+    parser.addHelpOption();
+    parser.process(app);
+
+    if (!parser.isSet(socketOption) || !parser.isSet(pluginOption))
+        parser.showHelp(-1);
+
+    qApp->setProperty(PROP_DISPLAY_MODE, QVariant::fromValue(static_cast<Dock::DisplayMode>(parser.value(displayModeOption).toInt())));
+    qApp->setProperty(PROP_POSITION, QVariant::fromValue(static_cast<Dock::Position>(parser.value(positionOption).toInt())));
+
+    LegacyPluginHost host(parser.value(socketOption), parser.value(pluginOption));
+    if (!host.start())
+        return -1;
+
+    return app.exec();
+}
@@ -7,6 +7,7 @@
 #include "pluginsiteminterface.h"
 #include "pluginsiteminterface_v20.h"
 #include "pluginadapter.h"
+#include "remotepluginadapter.h"
 #include "utils.h"
 #include "settingconfig.h"
 
@@ -15,11 +16,17 @@
 
 #include <QDebug>
 #include <QDir>
-#include <QMapIterator>
+#include <QFileSystemWatcher>
 #include <QPluginLoader>
+#include <QStandardPaths>
+#include <QSet>
+#include <QTimer>
+#include <QWidget>
 
-#define PLUGININFO "pluginInfo"
 #define DOCK_QUICK_PLUGINS "Dock_Quick_Plugins"
+#define SETTINGS_FLUSH_DELAY 300
+#define SETTINGS_FLUSH_MAX_DELAY 1000
+#define PLUGIN_RESCAN_DELAY 1000
 
 static const QStringList CompatiblePluginApiList {
     "1.1.1",
@@ -29,24 +36,46 @@ static const QStringList CompatiblePluginApiList {
     DOCK_PLUGIN_API_VERSION
 };
 
-class PluginInfo : public QObject
-{
-public:
-    PluginInfo() : QObject(nullptr), m_loaded(false), m_visible(false) {}
-    bool m_loaded;
-    bool m_visible;
-    QString m_itemKey;
-};
-
 DockPluginController::DockPluginController(PluginProxyInterface *proxyInter, QObject *parent)
     : QObject(parent)
     , m_dbusDaemonInterface(QDBusConnection::sessionBus().interface())
     , m_dockDaemonInter(new DockInter(dockServiceName(), dockServicePath(), QDBusConnection::sessionBus(), this))
+    , m_pendingPluginCount(0)
+    , m_initialLoadFinished(false)
+    , m_settingsRefreshing(false)
+    , m_settingsRefreshPending(false)
+    , m_settingsFlushTimer(new QTimer(this))
+    , m_settingsSaveCount(0)
+    , m_settingsFlushCount(0)
+    , m_settingsFlushBytes(0)
+    , m_settingsRemoveCount(0)
+    , m_pluginWatcher(new QFileSystemWatcher(this))
+    , m_pluginRescanTimer(new QTimer(this))
     , m_proxyInter(proxyInter)
 {
     qApp->installEventFilter(this);
 
-    refreshPluginSettings();
+    // 插件保存配置时先写入本地缓存，合并一段时间内的修改后再一次性写入daemon
+    m_settingsFlushTimer->setSingleShot(true);
+    connect(m_settingsFlushTimer, &QTimer::timeout, this, [ this ] { flushPluginSettings(false); });
+    // 退出前必须把未写入的配置同步写入daemon
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [ this ] { flushPluginSettings(true); });
+
+    // 插件目录中的插件文件发生变化时，只重新加载变化的插件，安装包升级时会连续修改多个文件，因此延迟处理
+    m_pluginRescanTimer->setSingleShot(true);
+    m_pluginRescanTimer->setInterval(PLUGIN_RESCAN_DELAY);
+    connect(m_pluginRescanTimer, &QTimer::timeout, this, &DockPluginController::onPluginDirsChanged);
+    connect(m_pluginWatcher, &QFileSystemWatcher::directoryChanged, this, [ this ](const QString &path) {
+        m_changedPluginDirs << cleanPluginDir(path);
+        m_pluginRescanTimer->start();
+    });
+    connect(m_pluginWatcher, &QFileSystemWatcher::fileChanged, this, [ this ](const QString &path) {
+        m_changedPluginDirs << cleanPluginDir(QFileInfo(path).absolutePath());
+        m_pluginRescanTimer->start();
+    });
+
+    // 插件初始化的时候就需要读取配置，因此第一次同步获取
+    applyPluginSettings(m_dockDaemonInter->GetPluginSettings().value(), false);
 
     connect(SETTINGCONFIG, &SettingConfig::valueChanged, this, &DockPluginController::onConfigChanged);
     connect(m_dockDaemonInter, &DockInter::PluginSettingsSynced, this, &DockPluginController::refreshPluginSettings, Qt::QueuedConnection);
@@ -54,14 +83,11 @@ DockPluginController::DockPluginController(PluginProxyInterface *proxyInter, QOb
 
 DockPluginController::~DockPluginController()
 {
-    for (auto inter : m_pluginsMap.keys()) {
-        delete m_pluginsMap.value(inter).value("pluginloader");
-        m_pluginsMap[inter]["pluginloader"] = nullptr;
-        if (m_pluginsMap[inter].contains(PLUGININFO))
-            m_pluginsMap[inter][PLUGININFO]->deleteLater();
-        m_pluginsMap.remove(inter);
-        delete inter;
-        inter = nullptr;
+    flushPluginSettings(true);
+
+    for (auto it = m_pluginsMap.begin(); it != m_pluginsMap.end(); it = m_pluginsMap.erase(it)) {
+        delete it.value().pluginLoader;
+        delete it.key();
     }
 }
 
@@ -85,13 +111,9 @@ QList<PluginsItemInterface *> DockPluginController::pluginsInSetting() const
         if (plugin->pluginDisplayName().isEmpty())
             continue;
 
-        QMap<QString, QObject *> pluginMap = it.value();
-        // 如果不包含PLUGININFO这个key值，肯定是未加载
-        if (!pluginMap.contains(PLUGININFO))
-            continue;
-
-        PluginInfo *pluginInfo = static_cast<PluginInfo *>(pluginMap[PLUGININFO]);
-        if (!pluginInfo->m_loaded)
+        // 未调用过itemAdded或者已经调用了itemRemoved的插件，肯定是未加载
+        const PluginInfo &pluginInfo = it.value();
+        if (!pluginInfo.loaded)
             continue;
 
         // 这里只需要返回插件为可以在控制中心设置的插件
@@ -99,7 +121,7 @@ QList<PluginsItemInterface *> DockPluginController::pluginsInSetting() const
             continue;
 
         settingPlugins << plugin;
-        pluginSort[plugin] = plugin->itemSortKey(pluginInfo->m_itemKey);
+        pluginSort[plugin] = plugin->itemSortKey(pluginInfo.itemKey);
     }
 
     std::sort(settingPlugins.begin(), settingPlugins.end(), [ pluginSort ](PluginsItemInterface *plugin1, PluginsItemInterface *plugin2) {
@@ -114,18 +136,14 @@ QList<PluginsItemInterface *> DockPluginController::currentPlugins() const
     QList<PluginsItemInterface *> loadedPlugins;
 
     QMap<PluginsItemInterface *, int> pluginSortMap;
-    for (auto it = m_pluginsMap.begin(); it != m_pluginsMap.end(); it++) {
-        QMap<QString, QObject *> objectMap = it.value();
-        if (!objectMap.contains(PLUGININFO))
-            continue;
-
-        PluginInfo *pluginInfo = static_cast<PluginInfo *>(objectMap[PLUGININFO]);
-        if (!pluginInfo->m_loaded)
+    for (auto it = m_pluginsMap.cbegin(); it != m_pluginsMap.cend(); it++) {
+        const PluginInfo &pluginInfo = it.value();
+        if (!pluginInfo.loaded)
             continue;
 
         PluginsItemInterface *plugin = it.key();
         loadedPlugins << plugin;
-        pluginSortMap[plugin] = plugin->itemSortKey(pluginInfo->m_itemKey);
+        pluginSortMap[plugin] = plugin->itemSortKey(pluginInfo.itemKey);
     }
 
     std::sort(loadedPlugins.begin(), loadedPlugins.end(), [ pluginSortMap ](PluginsItemInterface *pluginItem1, PluginsItemInterface *pluginItem2) {
@@ -161,19 +179,15 @@ void DockPluginController::itemAdded(PluginsItemInterface * const itemInter, con
     }
 
     // 如果是通过插件来调用m_proxyInter的
-    PluginInfo *pluginInfo = nullptr;
-    QMap<QString, QObject *> &interfaceData = m_pluginsMap[pluginItem];
-    if (interfaceData.contains(PLUGININFO)) {
-        pluginInfo = static_cast<PluginInfo *>(interfaceData[PLUGININFO]);
-        // 如果插件已经加载，则无需再次加载（此处保证插件出现重复调用itemAdded的情况）
-        if (pluginInfo->m_loaded)
-            return;
-    } else {
-        pluginInfo = new PluginInfo;
-        interfaceData[PLUGININFO] = pluginInfo;
-    }
-    pluginInfo->m_itemKey = itemKey;
-    pluginInfo->m_loaded = true;
+    PluginInfo &pluginInfo = m_pluginsMap[pluginItem];
+    // 如果插件已经加载，则无需再次加载（此处保证插件出现重复调用itemAdded的情况）
+    if (pluginInfo.loaded)
+        return;
+
+    pluginInfo.registered = true;
+    pluginInfo.itemKey = itemKey;
+    pluginInfo.loaded = true;
+    indexItem(pluginItem, itemKey);
 
     if (pluginCanDock(pluginItem))
         addPluginItem(pluginItem, itemKey);
@@ -190,14 +204,12 @@ void DockPluginController::itemRemoved(PluginsItemInterface * const itemInter, c
 {
     PluginsItemInterface *pluginInter = getPluginInterface(itemInter);
     // 更新字段中的isLoaded字段，表示当前没有加载
-    QMap<QString, QObject *> &interfaceData = m_pluginsMap[pluginInter];
-    if (interfaceData.contains(PLUGININFO)) {
-        PluginInfo *pluginInfo = static_cast<PluginInfo *>(interfaceData[PLUGININFO]);
-        // 将是否加载的标记修改为未加载
-        pluginInfo->m_loaded = false;
-    }
+    PluginInfo &pluginInfo = m_pluginsMap[pluginInter];
+    // 将是否加载的标记修改为未加载
+    pluginInfo.loaded = false;
 
     removePluginItem(pluginInter, itemKey);
+    unindexItem(pluginInter, itemKey);
     Q_EMIT pluginRemoved(pluginInter);
 }
 
@@ -232,57 +244,46 @@ PluginsItemInterface *DockPluginController::getPluginInterface(PluginsItemInterf
 void DockPluginController::addPluginItem(PluginsItemInterface * const itemInter, const QString &itemKey)
 {
     // 如果这个插件都没有加载，那么此处肯定是无需新增
-    if (!m_pluginsMap.contains(itemInter))
+    auto it = m_pluginsMap.find(itemInter);
+    if (it == m_pluginsMap.end())
         return;
 
-    PluginInfo *pluginInfo = nullptr;
-    QMap<QString, QObject *> &interfaceData = m_pluginsMap[itemInter];
-    // 此处的PLUGININFO的数据已经在前面调用的地方给填充了数据，如果没有获取到这个数据，则无需新增
-    if (!interfaceData.contains(PLUGININFO))
+    // 插件信息已经在前面调用itemAdded的地方给填充了数据，如果插件没有调用过itemAdded，则无需新增
+    if (!it.value().registered)
         return;
 
-    pluginInfo = static_cast<PluginInfo *>(interfaceData[PLUGININFO]);
-    pluginInfo->m_visible = true;
+    it.value().visible = true;
 
     m_proxyInter->itemAdded(itemInter, itemKey);
 }
 
 void DockPluginController::removePluginItem(PluginsItemInterface * const itemInter, const QString &itemKey)
 {
-    if (!m_pluginsMap.contains(itemInter))
+    auto it = m_pluginsMap.find(itemInter);
+    if (it == m_pluginsMap.end() || !it.value().registered)
         return;
 
-    // 更新字段中的isLoaded字段，表示当前没有加载
-    QMap<QString, QObject *> &interfaceData = m_pluginsMap[itemInter];
-    if (!interfaceData.contains(PLUGININFO))
-        return;
-
-    PluginInfo *pluginInfo = static_cast<PluginInfo *>(interfaceData[PLUGININFO]);
     // 将是否在任务栏显示的标记改为不显示
-    pluginInfo->m_visible = false;
+    it.value().visible = false;
     m_proxyInter->itemRemoved(itemInter, itemKey);
 }
 
 QString DockPluginController::itemKey(PluginsItemInterface *itemInter) const
 {
-    if (!m_pluginsMap.contains(itemInter))
+    auto it = m_pluginsMap.constFind(itemInter);
+    if (it == m_pluginsMap.constEnd())
         return QString();
 
-    QMap<QString, QObject *> interfaceData = m_pluginsMap[itemInter];
-    if (!interfaceData.contains(PLUGININFO))
-        return QString();
-
-    PluginInfo *pluginInfo = static_cast<PluginInfo *>(interfaceData[PLUGININFO]);
-    return pluginInfo->m_itemKey;
+    return it.value().itemKey;
 }
 
 QJsonObject DockPluginController::metaData(PluginsItemInterface *pluginItem)
 {
-    if (!m_pluginsMap.contains(pluginItem))
+    auto it = m_pluginsMap.constFind(pluginItem);
+    if (it == m_pluginsMap.constEnd())
         return QJsonObject();
 
-    QPluginLoader *pluginLoader = qobject_cast<QPluginLoader *>(m_pluginsMap[pluginItem].value("pluginloader"));
-
+    QPluginLoader *pluginLoader = it.value().pluginLoader;
     if (!pluginLoader)
         return QJsonObject();
 
@@ -306,11 +307,10 @@ void DockPluginController::savePluginValue(PluginsItemInterface * const itemInte
     if (itemInter->type() == PluginsItemInterface::Fixed && key == "enable" && !value.toBool()) {
         int fixedPluginCount = 0;
         // 遍历FixPlugin插件个数
-        for (auto it(m_pluginsMap.begin()); it != m_pluginsMap.end();) {
+        for (auto it = m_pluginsMap.cbegin(); it != m_pluginsMap.cend(); ++it) {
             if (it.key()->type() == PluginsItemInterface::Fixed) {
                 fixedPluginCount++;
             }
-            ++it;
         }
         // 修改插件的order值，位置为队尾
         QString name = localObject.keys().last();
@@ -324,7 +324,7 @@ void DockPluginController::savePluginValue(PluginsItemInterface * const itemInte
     }
 
     m_pluginSettingsObject.insert(itemInter->pluginName(), localObject);
-    m_dockDaemonInter->MergePluginSettings(QJsonDocument(remoteObject).toJson(QJsonDocument::JsonFormat::Compact));
+    queuePluginSettings(remoteObject);
 }
 
 const QVariant DockPluginController::getPluginValue(PluginsItemInterface * const itemInter, const QString &key, const QVariant &fallback)
@@ -340,17 +340,125 @@ const QVariant DockPluginController::getPluginValue(PluginsItemInterface * const
 
 void DockPluginController::removePluginValue(PluginsItemInterface * const itemInter, const QStringList &keyList)
 {
+    const QString pluginName = itemInter->pluginName();
     if (keyList.isEmpty()) {
-        m_pluginSettingsObject.remove(itemInter->pluginName());
+        m_pluginSettingsObject.remove(pluginName);
     } else {
-        QJsonObject localObject = m_pluginSettingsObject.value(itemInter->pluginName()).toObject();
+        QJsonObject localObject = m_pluginSettingsObject.value(pluginName).toObject();
         for (auto key : keyList) {
             localObject.remove(key);
         }
-        m_pluginSettingsObject.insert(itemInter->pluginName(), localObject);
+        m_pluginSettingsObject.insert(pluginName, localObject);
+    }
+
+    // 删除的配置不能再被后面的批量写入重新写回daemon
+    if (m_pendingSettingsObject.contains(pluginName)) {
+        QJsonObject pendingObject = m_pendingSettingsObject.value(pluginName).toObject();
+        for (const QString &key : keyList)
+            pendingObject.remove(key);
+
+        if (keyList.isEmpty() || pendingObject.isEmpty())
+            m_pendingSettingsObject.remove(pluginName);
+        else
+            m_pendingSettingsObject.insert(pluginName, pendingObject);
     }
 
-    m_dockDaemonInter->RemovePluginSettings(itemInter->pluginName(), keyList);
+    // 删除也合并到下一次批量写入中，已经要删除插件的所有配置时不再记录单独的配置项
+    auto removedIt = m_pendingRemovedSettings.find(pluginName);
+    if (keyList.isEmpty()) {
+        m_pendingRemovedSettings.insert(pluginName, QStringList());
+    } else if (removedIt == m_pendingRemovedSettings.end()) {
+        m_pendingRemovedSettings.insert(pluginName, keyList);
+    } else if (!removedIt.value().isEmpty()) {
+        for (const QString &key : keyList) {
+            if (!removedIt.value().contains(key))
+                removedIt.value() << key;
+        }
+    }
+
+    m_settingsRemoveCount++;
+    scheduleSettingsFlush();
+}
+
+void DockPluginController::queuePluginSettings(const QJsonObject &settingsObject)
+{
+    // 同一个插件的同一个配置项只保留最后一次的值
+    for (auto pluginsIt = settingsObject.constBegin(); pluginsIt != settingsObject.constEnd(); ++pluginsIt) {
+        QJsonObject pendingObject = m_pendingSettingsObject.value(pluginsIt.key()).toObject();
+        const QJsonObject &valueObject = pluginsIt.value().toObject();
+        for (auto valueIt = valueObject.constBegin(); valueIt != valueObject.constEnd(); ++valueIt)
+            pendingObject.insert(valueIt.key(), valueIt.value());
+
+        // 删除之后又重新保存的配置项不需要再删除
+        auto removedIt = m_pendingRemovedSettings.find(pluginsIt.key());
+        if (removedIt != m_pendingRemovedSettings.end() && !removedIt.value().isEmpty()) {
+            for (auto valueIt = valueObject.constBegin(); valueIt != valueObject.constEnd(); ++valueIt)
+                removedIt.value().removeAll(valueIt.key());
+
+            if (removedIt.value().isEmpty())
+                m_pendingRemovedSettings.erase(removedIt);
+        }
+
+        m_pendingSettingsObject.insert(pluginsIt.key(), pendingObject);
+    }
+
+    m_settingsSaveCount++;
+    scheduleSettingsFlush();
+}
+
+void DockPluginController::scheduleSettingsFlush()
+{
+    // 连续保存(例如拖动音量滑块)时一直推迟写入，但从第一次保存开始最多等待SETTINGS_FLUSH_MAX_DELAY
+    if (!m_pendingSince.isValid())
+        m_pendingSince.start();
+
+    const int remaining = SETTINGS_FLUSH_MAX_DELAY - static_cast<int>(m_pendingSince.elapsed());
+    m_settingsFlushTimer->start(qBound(0, remaining, SETTINGS_FLUSH_DELAY));
+}
+
+void DockPluginController::flushPluginSettings(bool waitForFinished)
+{
+    m_settingsFlushTimer->stop();
+    m_pendingSince.invalidate();
+
+    if (m_pendingSettingsObject.isEmpty() && m_pendingRemovedSettings.isEmpty())
+        return;
+
+    // 先删除再写入，删除之后重新保存的配置项在保存时已经从待删除的列表中去掉
+    QList<QDBusPendingCall> replies;
+    for (auto it = m_pendingRemovedSettings.constBegin(); it != m_pendingRemovedSettings.constEnd(); ++it)
+        replies << m_dockDaemonInter->RemovePluginSettings(it.key(), it.value());
+    m_pendingRemovedSettings.clear();
+
+    if (!m_pendingSettingsObject.isEmpty()) {
+        const QByteArray settings = QJsonDocument(m_pendingSettingsObject).toJson(QJsonDocument::JsonFormat::Compact);
+        m_pendingSettingsObject = QJsonObject();
+
+        m_settingsFlushBytes += static_cast<quint64>(settings.size());
+        replies << m_dockDaemonInter->MergePluginSettings(QString::fromUtf8(settings));
+    }
+
+    m_settingsFlushCount++;
+    updateSettingsStatistics();
+
+    if (waitForFinished) {
+        for (QDBusPendingCall &reply : replies)
+            reply.waitForFinished();
+    }
+}
+
+/**
+ * @brief DockPluginController::updateSettingsStatistics 更新配置批量写入的统计信息，
+ * 插件管理器运行在插件中，统计信息保存在qApp的属性中，由任务栏的GetPluginSettingsStats接口返回
+ */
+void DockPluginController::updateSettingsStatistics()
+{
+    QJsonObject statistics;
+    statistics.insert("saveCount", static_cast<qint64>(m_settingsSaveCount));
+    statistics.insert("removeCount", static_cast<qint64>(m_settingsRemoveCount));
+    statistics.insert("flushCount", static_cast<qint64>(m_settingsFlushCount));
+    statistics.insert("flushBytes", static_cast<qint64>(m_settingsFlushBytes));
+    qApp->setProperty(PROP_PLUGIN_SETTINGS_STATISTICS, QString::fromUtf8(QJsonDocument(statistics).toJson(QJsonDocument::Compact)));
 }
 
 void DockPluginController::startLoadPlugin(const QStringList &dirs)
@@ -360,93 +468,88 @@ void DockPluginController::startLoadPlugin(const QStringList &dirs)
         if (!dir.exists(path))
             continue;
 
-        startLoader(new PluginLoader(path, this));
+        m_pluginWatcher->addPath(path);
+        startLoader(new PluginLoader(path, this), true);
     }
 }
 
 bool DockPluginController::isPluginLoaded(PluginsItemInterface *itemInter)
 {
-    if (!m_pluginsMap.contains(itemInter))
-        return false;
-
-    QMap<QString, QObject *> pluginObject = m_pluginsMap.value(itemInter);
-    if (!pluginObject.contains(PLUGININFO))
+    auto it = m_pluginsMap.constFind(itemInter);
+    if (it == m_pluginsMap.constEnd())
         return false;
 
-    PluginInfo *pluginInfo = static_cast<PluginInfo *>(pluginObject.value(PLUGININFO));
-    return pluginInfo->m_visible;
+    return it.value().visible;
 }
 
 QObject *DockPluginController::pluginItemAt(PluginsItemInterface *const itemInter, const QString &itemKey) const
 {
-    if (!m_pluginsMap.contains(itemInter))
+    auto it = m_pluginsMap.constFind(itemInter);
+    if (it == m_pluginsMap.constEnd())
         return nullptr;
 
-    return m_pluginsMap[itemInter][itemKey];
+    return it.value().items.value(itemKey, nullptr);
 }
 
 PluginsItemInterface *DockPluginController::pluginInterAt(const QString &itemKey)
 {
-    QMapIterator<PluginsItemInterface *, QMap<QString, QObject *>> it(m_pluginsMap);
-    while (it.hasNext()) {
-        it.next();
-        if (it.value().keys().contains(itemKey)) {
-            return it.key();
-        }
-    }
-
-    return nullptr;
+    return m_itemKeyIndex.value(itemKey, nullptr);
 }
 
 PluginsItemInterface *DockPluginController::pluginInterAt(QObject *destItem)
 {
-    QMapIterator<PluginsItemInterface *, QMap<QString, QObject *>> it(m_pluginsMap);
-    while (it.hasNext()) {
-        it.next();
-        if (it.value().values().contains(destItem)) {
-            return it.key();
-        }
-    }
-
-    return nullptr;
+    return m_widgetIndex.value(destItem, nullptr);
 }
 
-void DockPluginController::startLoader(PluginLoader *loader)
+void DockPluginController::startLoader(PluginLoader *loader, bool delayed)
 {
     connect(loader, &PluginLoader::finished, loader, &PluginLoader::deleteLater, Qt::QueuedConnection);
     connect(loader, &PluginLoader::pluginFounded, this, [ = ](const QString &pluginFile) {
-        QPair<QString, PluginsItemInterface *> pair;
-        pair.first = pluginFile;
-        pair.second = nullptr;
-        m_pluginLoadMap.insert(pair, false);
-    });
-    connect(loader, &PluginLoader::pluginFounded, this, &DockPluginController::loadPlugin, Qt::QueuedConnection);
+        // 重新扫描插件目录时，已经加载的插件和文件未变化的不兼容插件都不需要再加载
+        if (m_pluginLoadMap.contains(pluginFile))
+            return;
+
+        const QDateTime lastModified = QFileInfo(pluginFile).lastModified();
+        if (m_rejectedPlugins.contains(pluginFile) && m_rejectedPlugins.value(pluginFile) == lastModified)
+            return;
+
+        m_rejectedPlugins.remove(pluginFile);
 
-    int delay = Utils::SettingValue("com.deepin.dde.dock", "/com/deepin/dde/dock/", "delay-plugins-time", 0).toInt();
+        PluginLoadState loadState;
+        loadState.lastModified = lastModified;
+        m_pluginLoadMap.insert(pluginFile, loadState);
+        m_pendingPluginCount++;
+
+        QMetaObject::invokeMethod(this, "loadPlugin", Qt::QueuedConnection, Q_ARG(QString, pluginFile));
+    }, Qt::QueuedConnection);
+
+    int delay = delayed ? Utils::SettingValue("com.deepin.dde.dock", "/com/deepin/dde/dock/", "delay-plugins-time", 0).toInt() : 0;
     QTimer::singleShot(delay, loader, [ = ] { loader->start(QThread::LowestPriority); });
 }
 
 void DockPluginController::displayModeChanged()
 {
     const Dock::DisplayMode displayMode = qApp->property(PROP_DISPLAY_MODE).value<Dock::DisplayMode>();
-    const auto inters = m_pluginsMap.keys();
-
-    for (auto inter : inters)
-        inter->displayModeChanged(displayMode);
+    for (auto it = m_pluginsMap.cbegin(); it != m_pluginsMap.cend(); ++it)
+        it.key()->displayModeChanged(displayMode);
 }
 
 void DockPluginController::positionChanged()
 {
     const Dock::Position position = qApp->property(PROP_POSITION).value<Dock::Position>();
-    const auto inters = m_pluginsMap.keys();
-
-    for (auto inter : inters)
-        inter->positionChanged(position);
+    for (auto it = m_pluginsMap.cbegin(); it != m_pluginsMap.cend(); ++it)
+        it.key()->positionChanged(position);
 }
 
 void DockPluginController::loadPlugin(const QString &pluginFile)
 {
-    QPluginLoader *pluginLoader = new QPluginLoader(pluginFile, this);
+    // 在等待加载的过程中插件文件已经被删除或者修改
+    if (!m_pluginLoadMap.contains(pluginFile))
+        return;
+
+    // 被替换的插件的旧动态库没有卸载，再次加载同一路径得到的仍然是旧的动态库，因此从新文件的副本加载
+    const QString libraryFile = m_retainedPlugins.contains(pluginFile) ? copyPluginFile(pluginFile) : pluginFile;
+    QPluginLoader *pluginLoader = new QPluginLoader(libraryFile, this);
     const QJsonObject &meta = pluginLoader->metaData().value("MetaData").toObject();
     const QString &pluginApi = meta.value("api").toString();
     bool pluginIsValid = true;
@@ -459,7 +562,14 @@ void DockPluginController::loadPlugin(const QString &pluginFile)
         pluginIsValid = false;
     }
 
-    PluginsItemInterface *interface = qobject_cast<PluginsItemInterface *>(pluginLoader->instance());
+    PluginsItemInterface *interface = nullptr;
+    if (pluginIsValid && RemotePluginAdapter::isolationEnabled() && RemotePluginAdapter::isLegacyPlugin(pluginLoader->metaData())) {
+        // 开启了插件隔离，v20插件不在任务栏进程中加载，而是交给独立的插件进程加载
+        interface = new RemotePluginAdapter(pluginFile, this);
+    } else {
+        interface = qobject_cast<PluginsItemInterface *>(pluginLoader->instance());
+    }
+
     if (!interface) {
         // 如果识别当前插件失败，就认为这个插件是v20的插件，将其转换为v20插件接口
         PluginsItemInterface_V20 *interface_v20 = qobject_cast<PluginsItemInterface_V20 *>(pluginLoader->instance());
@@ -473,6 +583,10 @@ void DockPluginController::loadPlugin(const QString &pluginFile)
         }
     }
 
+    // 动态库已经加载，副本不再需要
+    if (libraryFile != pluginFile)
+        QFile::remove(libraryFile);
+
     if (!interface) {
         qDebug() << objectName() << "load plugin failed!!!" << pluginLoader->errorString() << pluginFile;
 
@@ -483,42 +597,48 @@ void DockPluginController::loadPlugin(const QString &pluginFile)
     }
 
     if (!pluginIsValid) {
-        for (auto &pair : m_pluginLoadMap.keys()) {
-            if (pair.first == pluginFile) {
-                m_pluginLoadMap.remove(pair);
-            }
-        }
+        if (m_pluginLoadMap.remove(pluginFile) > 0)
+            m_pendingPluginCount--;
+
+        m_rejectedPlugins.insert(pluginFile, QFileInfo(pluginFile).lastModified());
+
         QString notifyMessage(tr("The plugin %1 is not compatible with the system."));
         Dtk::Core::DUtil::DNotifySender(notifyMessage.arg(QFileInfo(pluginFile).fileName())).appIcon("dialog-warning").call();
         return;
     }
 
-    if (interface->pluginName() == "multitasking" && (Utils::IS_WAYLAND_DISPLAY || Dtk::Core::DSysInfo::deepinType() == Dtk::Core::DSysInfo::DeepinServer)) {
-        for (auto &pair : m_pluginLoadMap.keys()) {
-            if (pair.first == pluginFile) {
-                m_pluginLoadMap.remove(pair);
-            }
-        }
+    RemotePluginAdapter *remoteAdapter = dynamic_cast<RemotePluginAdapter *>(interface);
+    if (remoteAdapter) {
+        // 插件进程中的插件在上报信息之后才知道名称，此时再做和本地插件一样的检查
+        connect(remoteAdapter, &RemotePluginAdapter::pluginInfoReceived, this, [ = ] {
+            qDebug() << objectName() << "remote plugin ready:" << remoteAdapter->pluginName() << pluginFile;
+            if (!pluginIsRejected(remoteAdapter->pluginName()))
+                return;
+
+            // 先停止插件进程，之后的消息不再处理
+            remoteAdapter->stopHost();
+            unloadPlugin(pluginFile);
+            m_rejectedPlugins.insert(pluginFile, QFileInfo(pluginFile).lastModified());
+        });
+    } else if (pluginIsRejected(interface->pluginName())) {
+        if (m_pluginLoadMap.remove(pluginFile) > 0)
+            m_pendingPluginCount--;
+
+        m_rejectedPlugins.insert(pluginFile, QFileInfo(pluginFile).lastModified());
         return;
     }
 
-    QMapIterator<QPair<QString, PluginsItemInterface *>, bool> it(m_pluginLoadMap);
-    while (it.hasNext()) {
-        it.next();
-        if (it.key().first == pluginFile) {
-            m_pluginLoadMap.remove(it.key());
-            QPair<QString, PluginsItemInterface *> newPair;
-            newPair.first = pluginFile;
-            newPair.second = interface;
-            m_pluginLoadMap.insert(newPair, false);
-            break;
-        }
-    }
+    auto loadIt = m_pluginLoadMap.find(pluginFile);
+    if (loadIt != m_pluginLoadMap.end())
+        loadIt.value().interface = interface;
 
     // 保存 PluginLoader 对象指针
-    QMap<QString, QObject *> interfaceData;
-    interfaceData["pluginloader"] = pluginLoader;
-    m_pluginsMap.insert(interface, interfaceData);
+    PluginInfo &pluginInfo = m_pluginsMap[interface];
+    pluginInfo.pluginLoader = pluginLoader;
+    pluginInfo.pluginFile = pluginFile;
+    // 直接覆盖插件文件时目录不会发生变化，因此还需要监控插件文件本身
+    m_pluginWatcher->addPath(pluginFile);
+
     QString dbusService = meta.value("depends-daemon-dbus-service").toString();
     if (!dbusService.isEmpty() && !m_dbusDaemonInterface->isServiceRegistered(dbusService).value()) {
         qDebug() << objectName() << dbusService << "daemon has not started, waiting for signal";
@@ -545,35 +665,177 @@ void DockPluginController::loadPlugin(const QString &pluginFile)
 
 void DockPluginController::initPlugin(PluginsItemInterface *interface)
 {
-    if (!interface)
+    // 等待初始化的过程中插件可能已经被卸载
+    if (!interface || !m_pluginsMap.contains(interface))
         return;
 
-    qDebug() << objectName() << "init plugin: " << interface->pluginName();
+    // 插件进程中的插件此时还没有上报名称，同时打印插件文件
+    const QString pluginFile = m_pluginsMap.value(interface).pluginFile;
+    qDebug() << objectName() << "init plugin: " << interface->pluginName() << pluginFile;
     interface->init(this);
 
-    for (const auto &pair : m_pluginLoadMap.keys()) {
-        if (pair.second == interface)
-            m_pluginLoadMap.insert(pair, true);
+    auto loadIt = m_pluginLoadMap.find(pluginFile);
+    if (loadIt != m_pluginLoadMap.end() && loadIt.value().interface == interface && !loadIt.value().initialized) {
+        loadIt.value().initialized = true;
+        m_pendingPluginCount--;
     }
 
-    bool loaded = true;
-    for (int i = 0; i < m_pluginLoadMap.keys().size(); ++i) {
-        if (!m_pluginLoadMap.values()[i]) {
-            loaded = false;
-            break;
-        }
+    // 插件全部加载完成，只在启动时通知一次，之后重新加载的插件通过itemAdded添加
+    if (m_pendingPluginCount == 0 && !m_initialLoadFinished) {
+        m_initialLoadFinished = true;
+        emit pluginLoadFinished();
     }
+    qDebug() << objectName() << "init plugin finished: " << interface->pluginName() << pluginFile;
+}
 
-    // 插件全部加载完成
-    if (loaded) {
-        emit pluginLoadFinished();
+/**
+ * @brief DockPluginController::pluginIsRejected 当前环境下不加载的插件
+ */
+bool DockPluginController::pluginIsRejected(const QString &pluginName) const
+{
+    return pluginName == "multitasking" && (Utils::IS_WAYLAND_DISPLAY || Dtk::Core::DSysInfo::deepinType() == Dtk::Core::DSysInfo::DeepinServer);
+}
+
+void DockPluginController::unloadPlugin(const QString &pluginFile)
+{
+    auto loadIt = m_pluginLoadMap.find(pluginFile);
+    if (loadIt == m_pluginLoadMap.end())
+        return;
+
+    PluginsItemInterface *interface = loadIt.value().interface;
+    if (!loadIt.value().initialized)
+        m_pendingPluginCount--;
+
+    m_pluginLoadMap.erase(loadIt);
+
+    auto it = m_pluginsMap.find(interface);
+    if (!interface || it == m_pluginsMap.end())
+        return;
+
+    qInfo() << objectName() << "unload plugin:" << interface->pluginName() << pluginFile;
+
+    const PluginInfo pluginInfo = it.value();
+    if (pluginInfo.visible)
+        removePluginItem(interface, pluginInfo.itemKey);
+
+    if (pluginInfo.loaded)
+        Q_EMIT pluginRemoved(interface);
+
+    for (const QString &itemKey : pluginInfo.items.keys())
+        unindexItem(interface, itemKey);
+
+    m_pluginsMap.remove(interface);
+    m_pluginWatcher->removePath(pluginFile);
+
+    for (auto adapterIt = m_pluginAdapterMap.begin(); adapterIt != m_pluginAdapterMap.end();) {
+        if (adapterIt.value() == interface)
+            adapterIt = m_pluginAdapterMap.erase(adapterIt);
+        else
+            ++adapterIt;
+    }
+
+    // 插件的窗口可能还被弹出窗口等持有，插件注册的元类型和静态对象也会一直存在，
+    // 卸载动态库之后这些代码都可能再被调用，因此只释放插件对象，动态库保持加载，不调用unload
+    QPluginLoader *pluginLoader = pluginInfo.pluginLoader;
+    if (pluginLoader && pluginLoader->isLoaded())
+        m_retainedPlugins.insert(pluginFile);
+
+    // 界面上的插件项是延迟删除的，等它们处理完之后再释放插件
+    QTimer::singleShot(0, this, [ interface, pluginLoader ] {
+        // 不调用unload时QPluginLoader不会释放插件的根对象：v23插件的接口就是根对象，
+        // v20插件的适配器在析构时释放根对象，插件进程的适配器没有在任务栏中加载动态库
+        delete interface;
+
+        if (pluginLoader)
+            pluginLoader->deleteLater();
+    });
+}
+
+/**
+ * @brief DockPluginController::copyPluginFile 把插件文件复制到运行时目录中，返回副本的路径，失败时返回原路径
+ */
+QString DockPluginController::copyPluginFile(const QString &pluginFile) const
+{
+    const QString dirPath = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + "/dde-dock/plugins";
+    if (!QDir().mkpath(dirPath)) {
+        qWarning() << objectName() << "create plugin copy dir failed:" << dirPath;
+        return pluginFile;
+    }
+
+    const QFileInfo fileInfo(pluginFile);
+    const QString copyFile = QString("%1/%2-%3.%4").arg(dirPath).arg(fileInfo.completeBaseName())
+            .arg(QDateTime::currentMSecsSinceEpoch()).arg(fileInfo.suffix());
+    if (!QFile::copy(pluginFile, copyFile)) {
+        qWarning() << objectName() << "copy plugin failed, the old plugin library will be reused:" << pluginFile;
+        return pluginFile;
+    }
+
+    return copyFile;
+}
+
+void DockPluginController::onPluginDirsChanged()
+{
+    const QSet<QString> changedDirs = m_changedPluginDirs;
+    m_changedPluginDirs.clear();
+
+    // 卸载被删除或者被修改的插件，其他插件保持不变
+    QStringList changedPlugins;
+    for (auto it = m_pluginLoadMap.constBegin(); it != m_pluginLoadMap.constEnd(); ++it) {
+        const QFileInfo fileInfo(it.key());
+        if (!changedDirs.contains(cleanPluginDir(fileInfo.absolutePath())))
+            continue;
+
+        if (!fileInfo.exists() || fileInfo.lastModified() != it.value().lastModified)
+            changedPlugins << it.key();
+    }
+
+    for (const QString &pluginFile : changedPlugins)
+        unloadPlugin(pluginFile);
+
+    // 重新扫描目录，新增的插件和修改后的插件会重新加载
+    for (const QString &path : changedDirs) {
+        if (!QDir(path).exists())
+            continue;
+
+        qDebug() << objectName() << "plugin directory changed:" << path << ", reload plugins:" << changedPlugins;
+        startLoader(new PluginLoader(path, this), false);
     }
-    qDebug() << objectName() << "init plugin finished: " << interface->pluginName();
+}
+
+QString DockPluginController::cleanPluginDir(const QString &path)
+{
+    return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
 }
 
 void DockPluginController::refreshPluginSettings()
 {
-    const QString &pluginSettings = m_dockDaemonInter->GetPluginSettings().value();
+    // 正在获取配置的时候又收到了同步信号，等这次返回后再获取一次
+    if (m_settingsRefreshing) {
+        m_settingsRefreshPending = true;
+        return;
+    }
+
+    m_settingsRefreshing = true;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_dockDaemonInter->GetPluginSettings(), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [ this ](QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<QString> reply = *call;
+        call->deleteLater();
+        m_settingsRefreshing = false;
+
+        if (reply.isError())
+            qWarning() << "get plugin settings failed:" << reply.error().message();
+        else
+            applyPluginSettings(reply.value(), true);
+
+        if (m_settingsRefreshPending) {
+            m_settingsRefreshPending = false;
+            refreshPluginSettings();
+        }
+    });
+}
+
+void DockPluginController::applyPluginSettings(const QString &pluginSettings, bool notifyPlugins)
+{
     if (pluginSettings.isEmpty()) {
         qDebug() << "Error! get plugin settings from dbus failed!";
         return;
@@ -589,40 +851,68 @@ void DockPluginController::refreshPluginSettings()
         return;
     }
 
+    // 只记录配置真正发生变化的插件
+    QSet<QString> changedPlugins;
     for (auto pluginsIt = pluginSettingsObject.constBegin(); pluginsIt != pluginSettingsObject.constEnd(); ++pluginsIt) {
         const QString &pluginName = pluginsIt.key();
         const QJsonObject &settingsObject = pluginsIt.value().toObject();
-        QJsonObject newSettingsObject = m_pluginSettingsObject.value(pluginName).toObject();
+        const QJsonObject &oldSettingsObject = m_pluginSettingsObject.value(pluginName).toObject();
+        QJsonObject newSettingsObject = oldSettingsObject;
+        // 还未写入daemon的配置以本地为准，避免被daemon中的旧值覆盖
+        const QJsonObject &pendingObject = m_pendingSettingsObject.value(pluginName).toObject();
+        // 还未从daemon中删除的配置也不能被daemon中的旧值恢复
+        const auto removedIt = m_pendingRemovedSettings.constFind(pluginName);
+        const bool removedAll = removedIt != m_pendingRemovedSettings.constEnd() && removedIt.value().isEmpty();
         for (auto settingsIt = settingsObject.constBegin(); settingsIt != settingsObject.constEnd(); ++settingsIt) {
+            if (pendingObject.contains(settingsIt.key()))
+                continue;
+
+            if (removedAll || (removedIt != m_pendingRemovedSettings.constEnd() && removedIt.value().contains(settingsIt.key())))
+                continue;
+
             newSettingsObject.insert(settingsIt.key(), settingsIt.value());
         }
+
+        if (newSettingsObject == oldSettingsObject)
+            continue;
+
         // TODO: remove not exists key-values
         m_pluginSettingsObject.insert(pluginName, newSettingsObject);
+        changedPlugins << pluginName;
     }
 
     // not notify plugins to refresh settings if this update is not emit by dock daemon
-    if (sender() != m_dockDaemonInter) {
+    if (!notifyPlugins || changedPlugins.isEmpty()) {
         return;
     }
 
-    // notify all plugins to reload plugin settings
-    for (PluginsItemInterface *pluginInter : m_pluginsMap.keys()) {
+    // 插件在pluginSettingsChanged中可能会新增或者移除插件，因此这里遍历插件的拷贝
+    const QList<PluginsItemInterface *> pluginList = m_pluginsMap.keys();
+    for (PluginsItemInterface *pluginInter : pluginList) {
+        if (!changedPlugins.contains(pluginInter->pluginName()))
+            continue;
+
+        // 记录配置变化之前每个插件项的位置和是否在容器中
+        QHash<QString, QPair<int, bool>> oldLayout;
+        const QList<QString> itemKeyList = m_pluginsMap.value(pluginInter).items.keys();
+        for (const QString &itemKey : itemKeyList)
+            oldLayout.insert(itemKey, qMakePair(pluginInter->itemSortKey(itemKey), pluginInter->itemIsInContainer(itemKey)));
+
+        // notify plugins to reload plugin settings
         pluginInter->pluginSettingsChanged();
-    }
 
-    // reload all plugin items for sort order or container
-    QMap<PluginsItemInterface *, QMap<QString, QObject *>> pluginsMapTemp = m_pluginsMap;
-    for (auto it = pluginsMapTemp.constBegin(); it != pluginsMapTemp.constEnd(); ++it) {
-        const QList<QString> &itemKeyList = it.value().keys();
-        for (auto key : itemKeyList) {
-            if (key != "pluginloader") {
-                itemRemoved(it.key(), key);
-            }
-        }
-        for (auto key : itemKeyList) {
-            if (key != "pluginloader") {
-                itemAdded(it.key(), key);
-            }
+        // reload plugin items only if sort order or container changed
+        for (auto it = oldLayout.constBegin(); it != oldLayout.constEnd(); ++it) {
+            const QString &itemKey = it.key();
+            // 插件自己已经移除了该插件项
+            if (!m_pluginsMap.value(pluginInter).items.contains(itemKey))
+                continue;
+
+            if (it.value() == qMakePair(pluginInter->itemSortKey(itemKey), pluginInter->itemIsInContainer(itemKey)))
+                continue;
+
+            itemRemoved(pluginInter, itemKey);
+            itemAdded(pluginInter, itemKey);
         }
     }
 }
@@ -658,17 +948,12 @@ bool DockPluginController::pluginCanDock(const QStringList &config, PluginsItemI
         return true;
 
     // 3、如果该插件并未加载（未调用itemAdde或已经调用itemRemoved)，则该插件不显示
-    if (!m_pluginsMap.contains(plugin))
-        return false;
-
-    const QMap<QString, QObject *> &pluginMap = m_pluginsMap[plugin];
-    // 如果不包含PLUGININFO，说明该插件从未调用itemAdded方法，无需加载
-    if (!pluginMap.contains(PLUGININFO))
+    auto it = m_pluginsMap.constFind(plugin);
+    if (it == m_pluginsMap.constEnd())
         return false;
 
-    // 如果该插件信息的m_loaded为true,说明已经调用过itemAdded方法，并且之后又调用了itemRemoved方法,则插件也无需加载
-    PluginInfo *pluginInfo = static_cast<PluginInfo *>(pluginMap[PLUGININFO]);
-    if (!pluginInfo->m_loaded)
+    // 如果从未调用itemAdded方法，或者调用过itemAdded方法之后又调用了itemRemoved方法，则插件也无需加载
+    if (!it.value().loaded)
         return false;
 
     // 4、插件已经驻留在任务栏，则始终显示
@@ -681,6 +966,34 @@ void DockPluginController::updateDockInfo(PluginsItemInterface * const itemInter
     Q_EMIT pluginUpdated(itemInter, part);
 }
 
+void DockPluginController::indexItem(PluginsItemInterface *itemInter, const QString &itemKey)
+{
+    QWidget *itemWidget = itemInter->itemWidget(itemKey);
+    m_pluginsMap[itemInter].items.insert(itemKey, itemWidget);
+    m_itemKeyIndex.insert(itemKey, itemInter);
+
+    if (!itemWidget || m_widgetIndex.contains(itemWidget))
+        return;
+
+    m_widgetIndex.insert(itemWidget, itemInter);
+    connect(itemWidget, &QObject::destroyed, this, [ this ](QObject *object) {
+        m_widgetIndex.remove(object);
+    });
+}
+
+void DockPluginController::unindexItem(PluginsItemInterface *itemInter, const QString &itemKey)
+{
+    auto it = m_pluginsMap.find(itemInter);
+    if (it != m_pluginsMap.end()) {
+        QObject *itemWidget = it.value().items.take(itemKey);
+        if (itemWidget && m_widgetIndex.value(itemWidget) == itemInter)
+            m_widgetIndex.remove(itemWidget);
+    }
+
+    if (m_itemKeyIndex.value(itemKey) == itemInter)
+        m_itemKeyIndex.remove(itemKey);
+}
+
 void DockPluginController::onConfigChanged(const QString &key, const QVariant &value)
 {
     if (key != DOCK_QUICK_PLUGINS)
@@ -12,10 +12,17 @@
 
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QSet>
 #include <QDBusConnectionInterface>
 
 class PluginsItemInterface;
 class PluginAdapter;
+class QPluginLoader;
+class QTimer;
+class QFileSystemWatcher;
 
 class DockPluginController : public QObject, protected PluginProxyInterface
 {
@@ -74,25 +81,84 @@ private:
     void removePluginItem(PluginsItemInterface * const itemInter, const QString &itemKey);
 
 private Q_SLOTS:
-    void startLoader(PluginLoader *loader);
+    void startLoader(PluginLoader *loader, bool delayed);
     void displayModeChanged();
     void positionChanged();
     void loadPlugin(const QString &pluginFile);
     void initPlugin(PluginsItemInterface *interface);
     void refreshPluginSettings();
+    void onPluginDirsChanged();
     void onConfigChanged(const QString &key, const QVariant &value);
 
+private:
+    struct PluginInfo {
+        QPluginLoader *pluginLoader = nullptr;
+        QString pluginFile;
+        bool registered = false;    // 插件是否调用过itemAdded方法
+        bool loaded = false;        // 调用过itemAdded且之后没有调用itemRemoved
+        bool visible = false;       // 是否在任务栏上显示
+        QString itemKey;
+        QHash<QString, QObject *> items;
+    };
+
+    struct PluginLoadState {
+        PluginsItemInterface *interface = nullptr;
+        bool initialized = false;
+        QDateTime lastModified;
+    };
+
+    void applyPluginSettings(const QString &pluginSettings, bool notifyPlugins);
+    void queuePluginSettings(const QJsonObject &settingsObject);
+    void scheduleSettingsFlush();
+    void flushPluginSettings(bool waitForFinished);
+    void updateSettingsStatistics();
+    void unloadPlugin(const QString &pluginFile);
+    bool pluginIsRejected(const QString &pluginName) const;
+    QString copyPluginFile(const QString &pluginFile) const;
+    static QString cleanPluginDir(const QString &path);
+    void indexItem(PluginsItemInterface *itemInter, const QString &itemKey);
+    void unindexItem(PluginsItemInterface *itemInter, const QString &itemKey);
+
 private:
     QDBusConnectionInterface *m_dbusDaemonInterface;
     DockInter *m_dockDaemonInter;
 
-    // interface,  "pluginloader", PluginLoader指针对象
-    QMap<PluginsItemInterface *, QMap<QString, QObject *>> m_pluginsMap;
+    // interface, 插件加载器及插件状态
+    QHash<PluginsItemInterface *, PluginInfo> m_pluginsMap;
+    // 反向索引，用于拖动、菜单和DBus等路径中根据itemKey或者窗口快速查找插件
+    QHash<QString, PluginsItemInterface *> m_itemKeyIndex;
+    QHash<QObject *, PluginsItemInterface *> m_widgetIndex;
 
-    // filepath, interface, loaded
-    QMap<QPair<QString, PluginsItemInterface *>, bool> m_pluginLoadMap;
+    // filepath, 插件的加载状态
+    QHash<QString, PluginLoadState> m_pluginLoadMap;
+    // 已经找到但是还未初始化完成的插件个数
+    int m_pendingPluginCount;
+    // 启动时的插件是否已经全部加载完成，pluginLoadFinished只发送一次
+    bool m_initialLoadFinished;
 
     QJsonObject m_pluginSettingsObject;
+    bool m_settingsRefreshing;
+    bool m_settingsRefreshPending;
+    // 还未写入daemon的配置，格式与daemon中的配置相同
+    QJsonObject m_pendingSettingsObject;
+    // 还未从daemon中删除的配置，key为插件名称，value为空时删除插件的所有配置
+    QHash<QString, QStringList> m_pendingRemovedSettings;
+    QTimer *m_settingsFlushTimer;
+    QElapsedTimer m_pendingSince;
+    quint64 m_settingsSaveCount;
+    quint64 m_settingsFlushCount;
+    quint64 m_settingsFlushBytes;
+    quint64 m_settingsRemoveCount;
+
+    // 监控插件目录，插件文件变化时只重新加载变化的插件
+    QFileSystemWatcher *m_pluginWatcher;
+    QTimer *m_pluginRescanTimer;
+    QSet<QString> m_changedPluginDirs;
+    // 加载失败的插件及其修改时间，文件没有变化时不再重复加载
+    QHash<QString, QDateTime> m_rejectedPlugins;
+    // 被卸载过但动态库仍然保持加载的插件文件，再次加载时需要从副本加载
+    QSet<QString> m_retainedPlugins;
+
     QMap<qulonglong, PluginAdapter *> m_pluginAdapterMap;
 
     PluginProxyInterface *m_proxyInter;
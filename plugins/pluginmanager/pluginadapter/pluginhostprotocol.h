@@ -0,0 +1,103 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef PLUGINHOSTPROTOCOL_H
+#define PLUGINHOSTPROTOCOL_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QIODevice>
+#include <QVariantList>
+
+/** 任务栏与独立插件进程(dde-dock-plugin-host)之间的通信协议
+ * 每一条消息由 quint32 长度头 + QDataStream 序列化的(类型, 参数列表)组成
+ * 插件界面通过共享内存传输，socket上只传递共享内存的key和尺寸
+ */
+namespace PluginHost {
+
+#define PLUGIN_HOST_STREAM_VERSION QDataStream::Qt_5_11
+
+enum MessageType : quint8 {
+    // host -> dock
+    Hello = 1,              // pluginName, pluginDisplayName, type, sizePolicy, allowDisable, isDisable
+    ItemAdded,              // itemKey, sortKey, allowContainer, isInContainer, command, hasTips
+    ItemRemoved,            // itemKey
+    ItemUpdate,             // itemKey
+    Frame,                  // role, itemKey, shmKey, size, bytesPerLine, devicePixelRatio, sizeHint
+    ContextMenu,            // itemKey, menuJson
+    ItemCommand,            // itemKey, command
+    RequestAutoHide,        // itemKey, autoHide
+    RequestRefreshVisible,  // itemKey
+    SaveValue,              // key, value
+    RemoveValue,            // keyList
+    GetValue,               // serial, key, fallback
+    Pong,                   // serial
+
+    // dock -> host
+    ValueReply = 64,        // serial, value
+    Resize,                 // itemKey, size, devicePixelRatio
+    MouseEvent,             // itemKey, eventType, pos, button, buttons, modifiers
+    WheelEvent,             // itemKey, pos, angleDelta, buttons, modifiers
+    HoverEvent,             // itemKey, entered
+    RequestContextMenu,     // itemKey
+    RequestTips,            // itemKey, devicePixelRatio
+    InvokeMenuItem,         // itemKey, menuId, checked
+    SetSortKey,             // itemKey, order
+    SetItemIsInContainer,   // itemKey, container
+    RefreshIcon,            // itemKey
+    DisplayModeChanged,     // displayMode
+    PositionChanged,        // position
+    PluginSettingsChanged,
+    PluginStateSwitched,
+    Ping                    // serial
+};
+
+enum FrameRole : quint8 {
+    ItemRole = 0,
+    TipsRole = 1
+};
+
+inline QByteArray encode(MessageType type, const QVariantList &args = QVariantList())
+{
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream.setVersion(PLUGIN_HOST_STREAM_VERSION);
+    payloadStream << quint8(type) << args;
+
+    QByteArray message;
+    QDataStream messageStream(&message, QIODevice::WriteOnly);
+    messageStream.setVersion(PLUGIN_HOST_STREAM_VERSION);
+    messageStream << quint32(payload.size());
+    message.append(payload);
+    return message;
+}
+
+// 从buffer头部取出一条完整的消息，数据不完整时返回false并保留buffer
+inline bool decode(QByteArray &buffer, MessageType &type, QVariantList &args)
+{
+    if (buffer.size() < int(sizeof(quint32)))
+        return false;
+
+    quint32 length = 0;
+    QDataStream headStream(buffer);
+    headStream.setVersion(PLUGIN_HOST_STREAM_VERSION);
+    headStream >> length;
+    if (buffer.size() < int(sizeof(quint32) + length))
+        return false;
+
+    const QByteArray payload = buffer.mid(sizeof(quint32), length);
+    buffer.remove(0, sizeof(quint32) + length);
+
+    quint8 rawType = 0;
+    QDataStream payloadStream(payload);
+    payloadStream.setVersion(PLUGIN_HOST_STREAM_VERSION);
+    payloadStream >> rawType >> args;
+    type = MessageType(rawType);
+    return payloadStream.status() == QDataStream::Ok;
+}
+
+}
+
+#endif // PLUGINHOSTPROTOCOL_H
@@ -0,0 +1,129 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "remoteitemwidget.h"
+#include "remotepluginadapter.h"
+
+#include <QPainter>
+#include <QMouseEvent>
+#include <QWheelEvent>
+
+RemoteItemWidget::RemoteItemWidget(RemotePluginAdapter *adapter, const QString &itemKey, bool interactive, QWidget *parent)
+    : QWidget(parent)
+    , m_adapter(adapter)
+    , m_itemKey(itemKey)
+    , m_interactive(interactive)
+{
+    setAttribute(Qt::WA_TranslucentBackground);
+    setMouseTracking(interactive);
+}
+
+void RemoteItemWidget::setFrame(const QImage &image, const QSize &sizeHint)
+{
+    m_frame = image;
+    if (m_sizeHint != sizeHint) {
+        m_sizeHint = sizeHint;
+        updateGeometry();
+    }
+
+    update();
+}
+
+const QImage &RemoteItemWidget::frame() const
+{
+    return m_frame;
+}
+
+QSize RemoteItemWidget::sizeHint() const
+{
+    if (m_sizeHint.isValid())
+        return m_sizeHint;
+
+    return QWidget::sizeHint();
+}
+
+void RemoteItemWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    if (m_frame.isNull())
+        return;
+
+    // 插件进程按照当前的devicePixelRatio渲染，此处直接绘制，不做缩放
+    QPainter painter(this);
+    painter.drawImage(QPoint(0, 0), m_frame);
+}
+
+void RemoteItemWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+
+    if (m_interactive)
+        m_adapter->sendResize(m_itemKey, size(), devicePixelRatioF());
+}
+
+void RemoteItemWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+
+    // 提示窗口在显示的时候才去请求最新的画面
+    if (!m_interactive)
+        m_adapter->requestTips(m_itemKey, devicePixelRatioF());
+}
+
+void RemoteItemWidget::mousePressEvent(QMouseEvent *event)
+{
+    forwardMouseEvent(event);
+    QWidget::mousePressEvent(event);
+}
+
+void RemoteItemWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    forwardMouseEvent(event);
+    QWidget::mouseReleaseEvent(event);
+}
+
+void RemoteItemWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    forwardMouseEvent(event);
+    QWidget::mouseDoubleClickEvent(event);
+}
+
+void RemoteItemWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    forwardMouseEvent(event);
+    QWidget::mouseMoveEvent(event);
+}
+
+void RemoteItemWidget::wheelEvent(QWheelEvent *event)
+{
+    if (m_interactive)
+        m_adapter->sendWheelEvent(m_itemKey, event);
+
+    QWidget::wheelEvent(event);
+}
+
+void RemoteItemWidget::enterEvent(QEvent *event)
+{
+    if (m_interactive)
+        m_adapter->sendHoverEvent(m_itemKey, true);
+
+    QWidget::enterEvent(event);
+}
+
+void RemoteItemWidget::leaveEvent(QEvent *event)
+{
+    if (m_interactive)
+        m_adapter->sendHoverEvent(m_itemKey, false);
+
+    QWidget::leaveEvent(event);
+}
+
+void RemoteItemWidget::forwardMouseEvent(QMouseEvent *event)
+{
+    // 转发后事件由QWidget的默认实现忽略，继续交给任务栏的PluginsItem处理(拖动，右键菜单等)
+    if (m_interactive)
+        m_adapter->sendMouseEvent(m_itemKey, event);
+}
@@ -0,0 +1,53 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef REMOTEITEMWIDGET_H
+#define REMOTEITEMWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+
+class RemotePluginAdapter;
+
+/** 独立插件进程中的插件窗口在任务栏中的替身
+ * @brief The RemoteItemWidget class
+ * 只负责绘制插件进程写入共享内存的画面，并将输入事件转发给插件进程
+ */
+
+class RemoteItemWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    RemoteItemWidget(RemotePluginAdapter *adapter, const QString &itemKey, bool interactive, QWidget *parent = nullptr);
+
+    void setFrame(const QImage &image, const QSize &sizeHint);
+    const QImage &frame() const;
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void enterEvent(QEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+
+private:
+    void forwardMouseEvent(QMouseEvent *event);
+
+private:
+    RemotePluginAdapter *m_adapter;
+    QString m_itemKey;
+    bool m_interactive;
+    QImage m_frame;
+    QSize m_sizeHint;
+};
+
+#endif // REMOTEITEMWIDGET_H
@@ -0,0 +1,582 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "remotepluginadapter.h"
+#include "remoteitemwidget.h"
+#include "pluginsiteminterface_v20.h"
+#include "settingconfig.h"
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QTimer>
+#include <QDebug>
+
+#define DOCK_ISOLATE_LEGACY_PLUGINS "Dock_Isolate_Legacy_Plugins"
+
+#define PING_INTERVAL 2000          // 心跳间隔
+#define HOST_HANG_TIMEOUT 6000      // 启动后超过该时间没有连接，或者没有收到心跳回复，认为插件进程已经卡死
+#define RESTART_DELAY 1000          // 第一次重启的延迟，之后每次加倍
+#define HOST_STABLE_TIME 60000      // 插件进程运行超过该时间后退出，重新计算重启次数
+#define MAX_RESTART_COUNT 5
+#define MAX_PENDING_BYTES (1024 * 1024)
+
+using namespace PluginHost;
+
+RemotePluginAdapter::RemotePluginAdapter(const QString &pluginFile, QObject *parent)
+    : QObject(parent)
+    , m_pluginFile(pluginFile)
+    , m_type(PluginType::Normal)
+    , m_sizePolicy(PluginSizePolicy::Custom)
+    , m_allowDisable(false)
+    , m_isDisable(false)
+    , m_hostProcess(new QProcess(this))
+    , m_server(new QLocalServer(this))
+    , m_pingTimer(new QTimer(this))
+    , m_pingSerial(0)
+    , m_restartCount(0)
+    , m_stopping(false)
+    , m_killPending(false)
+{
+    m_hostProcess->setProcessChannelMode(QProcess::ForwardedChannels);
+    m_pingTimer->setInterval(PING_INTERVAL);
+
+    connect(m_server, &QLocalServer::newConnection, this, &RemotePluginAdapter::onNewConnection);
+    connect(m_hostProcess, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, &RemotePluginAdapter::onHostFinished);
+    connect(m_pingTimer, &QTimer::timeout, this, &RemotePluginAdapter::onPingTimeout);
+}
+
+RemotePluginAdapter::~RemotePluginAdapter()
+{
+    stopHost();
+
+    // 已经被任务栏接管的窗口由其父窗口释放，这里只释放还没有被使用的窗口
+    for (const ItemState &state : m_items) {
+        if (state.widget && !state.widget->parent())
+            delete state.widget;
+        if (state.tipsWidget && !state.tipsWidget->parent())
+            delete state.tipsWidget;
+    }
+}
+
+bool RemotePluginAdapter::isolationEnabled()
+{
+    return SETTINGCONFIG->value(DOCK_ISOLATE_LEGACY_PLUGINS).toBool();
+}
+
+bool RemotePluginAdapter::isLegacyPlugin(const QJsonObject &metaData)
+{
+    // 只读取元数据，不会加载插件的动态库
+    return metaData.value("IID").toString() == ModuleInterfaceV20_iid;
+}
+
+const QString RemotePluginAdapter::pluginName() const
+{
+    return m_pluginName;
+}
+
+const QString RemotePluginAdapter::pluginDisplayName() const
+{
+    return m_pluginDisplayName;
+}
+
+void RemotePluginAdapter::init(PluginProxyInterface *proxyInter)
+{
+    if (m_proxyInter == proxyInter)
+        return;
+
+    m_proxyInter = proxyInter;
+    startHost();
+}
+
+QWidget *RemotePluginAdapter::itemWidget(const QString &itemKey)
+{
+    if (!m_items.contains(itemKey))
+        return nullptr;
+
+    ItemState &state = m_items[itemKey];
+    if (!state.widget)
+        state.widget = new RemoteItemWidget(this, itemKey, true);
+
+    return state.widget;
+}
+
+QWidget *RemotePluginAdapter::itemTipsWidget(const QString &itemKey)
+{
+    if (!m_items.contains(itemKey))
+        return nullptr;
+
+    ItemState &state = m_items[itemKey];
+    if (!state.hasTips)
+        return nullptr;
+
+    if (!state.tipsWidget)
+        state.tipsWidget = new RemoteItemWidget(this, itemKey, false);
+
+    return state.tipsWidget;
+}
+
+const QString RemotePluginAdapter::itemCommand(const QString &itemKey)
+{
+    return m_items.value(itemKey).command;
+}
+
+const QString RemotePluginAdapter::itemContextMenu(const QString &itemKey)
+{
+    // 返回的是最近一次悬停时插件进程提供的菜单，不会等待插件进程
+    return m_items.value(itemKey).contextMenu;
+}
+
+void RemotePluginAdapter::invokedMenuItem(const QString &itemKey, const QString &menuId, const bool checked)
+{
+    send(InvokeMenuItem, { itemKey, menuId, checked });
+}
+
+int RemotePluginAdapter::itemSortKey(const QString &itemKey)
+{
+    return m_items.value(itemKey).sortKey;
+}
+
+void RemotePluginAdapter::setSortKey(const QString &itemKey, const int order)
+{
+    if (m_items.contains(itemKey))
+        m_items[itemKey].sortKey = order;
+
+    send(SetSortKey, { itemKey, order });
+}
+
+bool RemotePluginAdapter::itemAllowContainer(const QString &itemKey)
+{
+    return m_items.value(itemKey).allowContainer;
+}
+
+bool RemotePluginAdapter::itemIsInContainer(const QString &itemKey)
+{
+    return m_items.value(itemKey).inContainer;
+}
+
+void RemotePluginAdapter::setItemIsInContainer(const QString &itemKey, const bool container)
+{
+    if (m_items.contains(itemKey))
+        m_items[itemKey].inContainer = container;
+
+    send(SetItemIsInContainer, { itemKey, container });
+}
+
+bool RemotePluginAdapter::pluginIsAllowDisable()
+{
+    return m_allowDisable;
+}
+
+bool RemotePluginAdapter::pluginIsDisable()
+{
+    return m_isDisable;
+}
+
+void RemotePluginAdapter::pluginStateSwitched()
+{
+    m_isDisable = !m_isDisable;
+    send(PluginStateSwitched);
+}
+
+void RemotePluginAdapter::displayModeChanged(const Dock::DisplayMode displayMode)
+{
+    send(DisplayModeChanged, { int(displayMode) });
+}
+
+void RemotePluginAdapter::positionChanged(const Dock::Position position)
+{
+    send(PositionChanged, { int(position) });
+}
+
+void RemotePluginAdapter::refreshIcon(const QString &itemKey)
+{
+    send(RefreshIcon, { itemKey });
+}
+
+void RemotePluginAdapter::pluginSettingsChanged()
+{
+    send(PluginSettingsChanged);
+}
+
+PluginsItemInterface::PluginType RemotePluginAdapter::type()
+{
+    return m_type;
+}
+
+PluginsItemInterface::PluginSizePolicy RemotePluginAdapter::pluginSizePolicy() const
+{
+    return m_sizePolicy;
+}
+
+QIcon RemotePluginAdapter::icon(const DockPart &dockPart, DGuiApplicationHelper::ColorType themeType)
+{
+    Q_UNUSED(themeType);
+
+    switch (dockPart) {
+    case DockPart::QuickPanel:
+    case DockPart::SystemPanel: {
+        // 和PluginAdapter一样使用插件窗口的画面作为图标，这里直接使用插件进程最近一次提供的画面
+        for (const ItemState &state : m_items) {
+            if (state.added && state.widget && !state.widget->frame().isNull())
+                return QPixmap::fromImage(state.widget->frame());
+        }
+        break;
+    }
+    default: break;
+    }
+
+    return QIcon();
+}
+
+PluginsItemInterface::PluginMode RemotePluginAdapter::status() const
+{
+    return PluginMode::Active;
+}
+
+QString RemotePluginAdapter::description() const
+{
+    return m_pluginDisplayName;
+}
+
+PluginFlags RemotePluginAdapter::flags() const
+{
+    if (m_pluginFile.contains(TRAY_PATH))
+        return PluginFlag::Type_Tray | PluginFlag::Attribute_CanDrag | PluginFlag::Attribute_CanInsert;
+
+    return PluginsItemInterface::flags();
+}
+
+void RemotePluginAdapter::restartHost()
+{
+    stopHost();
+    startHost();
+}
+
+void RemotePluginAdapter::sendResize(const QString &itemKey, const QSize &size, qreal devicePixelRatio)
+{
+    send(Resize, { itemKey, size, devicePixelRatio });
+}
+
+void RemotePluginAdapter::sendMouseEvent(const QString &itemKey, QMouseEvent *event)
+{
+    send(MouseEvent, { itemKey, int(event->type()), event->localPos(), int(event->button()),
+                       int(event->buttons()), int(event->modifiers()) });
+
+    // 右键时插件可能会更新菜单，提前请求最新的菜单以便下次使用
+    if (event->type() == QEvent::MouseButtonPress && event->button() == Qt::RightButton)
+        send(RequestContextMenu, { itemKey });
+}
+
+void RemotePluginAdapter::sendWheelEvent(const QString &itemKey, QWheelEvent *event)
+{
+    send(WheelEvent, { itemKey, event->posF(), event->angleDelta(), int(event->buttons()), int(event->modifiers()) });
+}
+
+void RemotePluginAdapter::sendHoverEvent(const QString &itemKey, bool entered)
+{
+    send(HoverEvent, { itemKey, entered });
+
+    if (entered)
+        send(RequestContextMenu, { itemKey });
+}
+
+void RemotePluginAdapter::requestTips(const QString &itemKey, qreal devicePixelRatio)
+{
+    send(RequestTips, { itemKey, devicePixelRatio });
+}
+
+void RemotePluginAdapter::onNewConnection()
+{
+    QLocalSocket *socket = m_server->nextPendingConnection();
+    if (!socket)
+        return;
+
+    // 每个插件进程只允许一个连接
+    if (m_socket) {
+        socket->abort();
+        socket->deleteLater();
+        return;
+    }
+
+    m_socket = socket;
+    m_readBuffer.clear();
+    m_lastPong.restart();
+    connect(socket, &QLocalSocket::readyRead, this, &RemotePluginAdapter::onReadyRead);
+    connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+}
+
+void RemotePluginAdapter::onReadyRead()
+{
+    if (!m_socket)
+        return;
+
+    m_readBuffer.append(m_socket->readAll());
+
+    MessageType type;
+    QVariantList args;
+    while (decode(m_readBuffer, type, args)) {
+        handleMessage(type, args);
+        args.clear();
+    }
+}
+
+void RemotePluginAdapter::onHostFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    if (m_stopping)
+        return;
+
+    // stopHost中没有等到退出的进程，已经处理过了
+    if (m_killPending) {
+        m_killPending = false;
+        return;
+    }
+
+    qWarning() << "plugin host exited:" << m_pluginFile << exitCode << exitStatus;
+
+    m_pingTimer->stop();
+    if (m_socket)
+        m_socket->abort();
+
+    scheduleRestart();
+}
+
+void RemotePluginAdapter::onPingTimeout()
+{
+    // 心跳计时从启动插件进程时开始，插件进程在连接之前卡住也能检测到
+    if (m_lastPong.elapsed() > HOST_HANG_TIMEOUT) {
+        qWarning() << "plugin host is not responding, kill it:" << m_pluginFile;
+        stopHost();
+        scheduleRestart();
+        return;
+    }
+
+    if (!m_socket)
+        return;
+
+    send(Ping, { ++m_pingSerial });
+}
+
+/**
+ * @brief RemotePluginAdapter::scheduleRestart 插件进程崩溃或者卡死后延迟重启
+ * 重启的延迟随次数加倍，短时间内重启次数过多时不再重启
+ */
+void RemotePluginAdapter::scheduleRestart()
+{
+    if (m_hostUptime.elapsed() > HOST_STABLE_TIME)
+        m_restartCount = 0;
+
+    if (++m_restartCount > MAX_RESTART_COUNT) {
+        qWarning() << "plugin host failed too many times, give up:" << m_pluginFile;
+        return;
+    }
+
+    QTimer::singleShot(RESTART_DELAY << (m_restartCount - 1), this, &RemotePluginAdapter::startHost);
+}
+
+void RemotePluginAdapter::startHost()
+{
+    if (m_hostProcess->state() != QProcess::NotRunning)
+        return;
+
+    const QString serverName = QString("dde-dock-plugin-host-%1-%2").arg(QCoreApplication::applicationPid()).arg(quintptr(this), 0, 16);
+    if (!m_server->isListening()) {
+        QLocalServer::removeServer(serverName);
+        if (!m_server->listen(serverName)) {
+            qWarning() << "plugin host listen failed:" << serverName << m_server->errorString();
+            return;
+        }
+    }
+
+    const QStringList arguments {
+        "--socket", serverName,
+        "--plugin", m_pluginFile,
+        "--display-mode", QString::number(displayMode()),
+        "--position", QString::number(position())
+    };
+
+    m_hostProcess->start(hostPath(), arguments);
+    m_hostUptime.start();
+    m_lastPong.start();
+    m_pingTimer->start();
+}
+
+void RemotePluginAdapter::stopHost()
+{
+    m_stopping = true;
+    m_pingTimer->stop();
+
+    if (m_socket) {
+        m_socket->abort();
+        m_socket->deleteLater();
+    }
+    m_readBuffer.clear();
+
+    if (m_hostProcess->state() != QProcess::NotRunning) {
+        m_hostProcess->kill();
+        // 没有及时退出时，之后收到的退出信号不再当作崩溃处理
+        m_killPending = !m_hostProcess->waitForFinished(100);
+    }
+
+    qDeleteAll(m_sharedMemories);
+    m_sharedMemories.clear();
+    m_stopping = false;
+}
+
+void RemotePluginAdapter::send(MessageType type, const QVariantList &args)
+{
+    if (!m_socket || m_socket->state() != QLocalSocket::ConnectedState)
+        return;
+
+    // 插件进程卡住的时候不再继续堆积消息，等待心跳超时后重启插件进程
+    if (m_socket->bytesToWrite() > MAX_PENDING_BYTES)
+        return;
+
+    m_socket->write(encode(type, args));
+}
+
+void RemotePluginAdapter::handleMessage(MessageType type, const QVariantList &args)
+{
+    switch (type) {
+    case Hello: {
+        if (args.size() < 6)
+            break;
+        const bool firstHello = m_pluginName.isEmpty();
+        m_pluginName = args[0].toString();
+        m_pluginDisplayName = args[1].toString();
+        m_type = args[2].toInt() == PluginsItemInterface_V20::Fixed ? PluginType::Fixed : PluginType::Normal;
+        m_sizePolicy = args[3].toInt() == PluginsItemInterface_V20::System ? PluginSizePolicy::System : PluginSizePolicy::Custom;
+        m_allowDisable = args[4].toBool();
+        m_isDisable = args[5].toBool();
+        // 插件进程重启后也会发送Hello，只在第一次时通知
+        if (firstHello)
+            Q_EMIT pluginInfoReceived();
+        break;
+    }
+    case ItemAdded: {
+        if (args.size() < 6)
+            break;
+        const QString itemKey = args[0].toString();
+        ItemState &state = m_items[itemKey];
+        state.sortKey = args[1].toInt();
+        state.allowContainer = args[2].toBool();
+        state.inContainer = args[3].toBool();
+        state.command = args[4].toString();
+        state.hasTips = args[5].toBool();
+        if (!state.added) {
+            state.added = true;
+            m_proxyInter->itemAdded(this, itemKey);
+        } else if (state.widget) {
+            // 插件进程重启后，任务栏中的窗口仍然保留，重新告知插件进程窗口的尺寸
+            sendResize(itemKey, state.widget->size(), state.widget->devicePixelRatioF());
+        }
+        break;
+    }
+    case ItemRemoved: {
+        const QString itemKey = args.value(0).toString();
+        if (m_items.contains(itemKey) && m_items[itemKey].added) {
+            m_items[itemKey].added = false;
+            m_proxyInter->itemRemoved(this, itemKey);
+        }
+        break;
+    }
+    case ItemUpdate:
+        m_proxyInter->itemUpdate(this, args.value(0).toString());
+        break;
+    case Frame:
+        updateFrame(args);
+        break;
+    case ContextMenu:
+        if (m_items.contains(args.value(0).toString()))
+            m_items[args.value(0).toString()].contextMenu = args.value(1).toString();
+        break;
+    case ItemCommand:
+        if (m_items.contains(args.value(0).toString()))
+            m_items[args.value(0).toString()].command = args.value(1).toString();
+        break;
+    case RequestAutoHide:
+        m_proxyInter->requestWindowAutoHide(this, args.value(0).toString(), args.value(1).toBool());
+        break;
+    case RequestRefreshVisible:
+        m_proxyInter->requestRefreshWindowVisible(this, args.value(0).toString());
+        break;
+    case SaveValue:
+        m_proxyInter->saveValue(this, args.value(0).toString(), args.value(1));
+        break;
+    case RemoveValue:
+        m_proxyInter->removeValue(this, args.value(0).toStringList());
+        break;
+    case GetValue:
+        send(ValueReply, { args.value(0), m_proxyInter->getValue(this, args.value(1).toString(), args.value(2)) });
+        break;
+    case Pong:
+        m_lastPong.restart();
+        break;
+    default:
+        qWarning() << "unknown message from plugin host:" << type;
+        break;
+    }
+}
+
+void RemotePluginAdapter::updateFrame(const QVariantList &args)
+{
+    if (args.size() < 7)
+        return;
+
+    const int role = args[0].toInt();
+    const QString itemKey = args[1].toString();
+    const QString shmKey = args[2].toString();
+    const QSize size = args[3].toSize();
+    const int bytesPerLine = args[4].toInt();
+    const qreal devicePixelRatio = args[5].toReal();
+    const QSize sizeHint = args[6].toSize();
+
+    if (!m_items.contains(itemKey))
+        return;
+
+    RemoteItemWidget *widget = (role == TipsRole) ? m_items[itemKey].tipsWidget.data() : m_items[itemKey].widget.data();
+    if (!widget)
+        return;
+
+    // 插件进程在画面变大时会重新申请一块共享内存，key随之改变
+    const QString memoryKey = QString("%1/%2").arg(role).arg(itemKey);
+    QSharedMemory *sharedMemory = m_sharedMemories.value(memoryKey);
+    if (!sharedMemory || sharedMemory->key() != shmKey) {
+        delete sharedMemory;
+        sharedMemory = new QSharedMemory(shmKey);
+        m_sharedMemories[memoryKey] = sharedMemory;
+    }
+
+    if (!sharedMemory->isAttached() && !sharedMemory->attach(QSharedMemory::ReadOnly)) {
+        qWarning() << "attach plugin frame failed:" << shmKey << sharedMemory->errorString();
+        return;
+    }
+
+    if (size.isEmpty() || !sharedMemory->lock())
+        return;
+
+    QImage frame;
+    if (sharedMemory->size() >= bytesPerLine * size.height()) {
+        const QImage image(static_cast<const uchar *>(sharedMemory->constData()), size.width(), size.height(),
+                           bytesPerLine, QImage::Format_ARGB32_Premultiplied);
+        frame = image.copy();
+    }
+    sharedMemory->unlock();
+
+    frame.setDevicePixelRatio(devicePixelRatio);
+    widget->setFrame(frame, sizeHint);
+}
+
+QString RemotePluginAdapter::hostPath() const
+{
+#ifdef QT_DEBUG
+    return QString("%1/../plugins/dde-dock-plugin-host").arg(qApp->applicationDirPath());
+#else
+    return QString("/usr/lib/dde-dock/dde-dock-plugin-host");
+#endif
+}
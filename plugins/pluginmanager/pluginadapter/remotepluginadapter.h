@@ -0,0 +1,138 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef REMOTEPLUGINADAPTER_H
+#define REMOTEPLUGINADAPTER_H
+
+#include "pluginsiteminterface.h"
+#include "pluginhostprotocol.h"
+
+#include <QObject>
+#include <QProcess>
+#include <QPointer>
+#include <QElapsedTimer>
+
+class QLocalServer;
+class QLocalSocket;
+class QSharedMemory;
+class QTimer;
+class QMouseEvent;
+class QWheelEvent;
+class RemoteItemWidget;
+
+/** 适配器，v20插件在独立进程(dde-dock-plugin-host)中加载时，通过该接口转成v23接口的插件
+ * @brief The RemotePluginAdapter class
+ * 插件的所有状态都缓存在任务栏进程中，向插件进程发送的请求都是异步的，
+ * 插件进程卡死或者崩溃时只会重启插件进程，不会阻塞任务栏
+ */
+
+class RemotePluginAdapter : public QObject, public PluginsItemInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(PluginsItemInterface)
+
+public:
+    explicit RemotePluginAdapter(const QString &pluginFile, QObject *parent = nullptr);
+    ~RemotePluginAdapter() override;
+
+    static bool isolationEnabled();
+    static bool isLegacyPlugin(const QJsonObject &metaData);
+
+    const QString pluginName() const override;
+    const QString pluginDisplayName() const override;
+    void init(PluginProxyInterface *proxyInter) override;
+    QWidget *itemWidget(const QString &itemKey) override;
+
+    QWidget *itemTipsWidget(const QString &itemKey) override;
+    const QString itemCommand(const QString &itemKey) override;
+    const QString itemContextMenu(const QString &itemKey) override;
+    void invokedMenuItem(const QString &itemKey, const QString &menuId, const bool checked) override;
+    int itemSortKey(const QString &itemKey) override;
+    void setSortKey(const QString &itemKey, const int order) override;
+    bool itemAllowContainer(const QString &itemKey) override;
+    bool itemIsInContainer(const QString &itemKey) override;
+    void setItemIsInContainer(const QString &itemKey, const bool container) override;
+
+    bool pluginIsAllowDisable() override;
+    bool pluginIsDisable() override;
+    void pluginStateSwitched() override;
+    void displayModeChanged(const Dock::DisplayMode displayMode) override;
+    void positionChanged(const Dock::Position position) override;
+    void refreshIcon(const QString &itemKey) override;
+    void pluginSettingsChanged() override;
+    PluginType type() override;
+    PluginSizePolicy pluginSizePolicy() const override;
+
+    QIcon icon(const DockPart &dockPart, DGuiApplicationHelper::ColorType themeType = DGuiApplicationHelper::instance()->themeType()) override;
+    PluginMode status() const override;
+    QString description() const override;
+    PluginFlags flags() const override;
+
+    void restartHost();
+    void stopHost();
+
+    // 由RemoteItemWidget调用，转发给插件进程
+    void sendResize(const QString &itemKey, const QSize &size, qreal devicePixelRatio);
+    void sendMouseEvent(const QString &itemKey, QMouseEvent *event);
+    void sendWheelEvent(const QString &itemKey, QWheelEvent *event);
+    void sendHoverEvent(const QString &itemKey, bool entered);
+    void requestTips(const QString &itemKey, qreal devicePixelRatio);
+
+Q_SIGNALS:
+    // 插件进程第一次上报插件名称等信息，在此之前pluginName()为空
+    void pluginInfoReceived();
+
+private Q_SLOTS:
+    void onNewConnection();
+    void onReadyRead();
+    void onHostFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onPingTimeout();
+
+private:
+    struct ItemState {
+        bool added = false;
+        int sortKey = 1;
+        bool allowContainer = false;
+        bool inContainer = false;
+        bool hasTips = false;
+        QString command;
+        QString contextMenu;
+        QPointer<RemoteItemWidget> widget;
+        QPointer<RemoteItemWidget> tipsWidget;
+    };
+
+    void startHost();
+    void scheduleRestart();
+    void send(PluginHost::MessageType type, const QVariantList &args = QVariantList());
+    void handleMessage(PluginHost::MessageType type, const QVariantList &args);
+    void updateFrame(const QVariantList &args);
+    QString hostPath() const;
+
+private:
+    QString m_pluginFile;
+    QString m_pluginName;
+    QString m_pluginDisplayName;
+    PluginType m_type;
+    PluginSizePolicy m_sizePolicy;
+    bool m_allowDisable;
+    bool m_isDisable;
+
+    QProcess *m_hostProcess;
+    QLocalServer *m_server;
+    QPointer<QLocalSocket> m_socket;
+    QByteArray m_readBuffer;
+    QTimer *m_pingTimer;
+    QElapsedTimer m_lastPong;
+    QElapsedTimer m_hostUptime;
+    quint32 m_pingSerial;
+    int m_restartCount;
+    bool m_stopping;
+    bool m_killPending;                                 // 已经被杀死但还没有退出的插件进程
+
+    QMap<QString, ItemState> m_items;
+    QMap<QString, QSharedMemory *> m_sharedMemories;
+};
+
+#endif // REMOTEPLUGINADAPTER_H
@@ -0,0 +1,361 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/** 任务栏主面板的性能测试
+ * 在offscreen平台上构造带有N个图标的MainPanelControl，测量插入、移除、移动、图标大小计算和完整绘制的耗时，
+ * 耗时结果由QtTest输出(例如 -o result.xml,xml 或者 -csv)，每次操作的内存分配次数写入DOCK_BENCHMARK_OUTPUT指定的json文件
+ */
+
+#include "dockapplication.h"
+#include "constants.h"
+#include "dbusutil.h"
+#include "mockdockdaemon.h"
+
+#define private public
+#include "mainpanelcontrol.h"
+#include "dockitem.h"
+#include "placeholderitem.h"
+#undef private
+
+#include <QTest>
+#include <QDBusConnection>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QPainter>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 统计内存分配次数
+static std::atomic<quint64> g_allocationCount(0);
+
+void *operator new(std::size_t size)
+{
+    g_allocationCount++;
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+/** 用于性能测试的图标，只绘制一个圆角矩形
+ * @brief The BenchDockItem class
+ */
+class BenchDockItem : public DockItem
+{
+    Q_OBJECT
+
+public:
+    explicit BenchDockItem(ItemType type, QWidget *parent = nullptr)
+        : DockItem(parent)
+        , m_type(type)
+    {
+    }
+
+    ItemType itemType() const override { return m_type; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event);
+
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setBrush(QColor(255, 255, 255, 80));
+        painter.drawRoundedRect(rect().adjusted(4, 4, -4, -4), 8, 8);
+    }
+
+private:
+    ItemType m_type;
+};
+
+class Bench_MainPanelControl : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void insertItem_data() { addRows(); }
+    void insertItem();
+    void removeItem_data() { addRows(); }
+    void removeItem();
+    void moveItem_data() { addRows(); }
+    void moveItem();
+    void resizeDockIconFull_data() { addRows(); }
+    void resizeDockIconFull();
+    void resizeDockIconIncremental_data() { addRows(); }
+    void resizeDockIconIncremental();
+    void repaint_data() { addRows(); }
+    void repaint();
+
+private:
+    void addRows();
+    MainPanelControl *createPanel();
+    void destroyPanel();
+    void fillItems(int count);
+    void flushLayout();
+    void recordAllocations(const char *operation, quint64 allocations);
+
+private:
+    MockDockDaemon *m_daemon;
+    DockInter *m_dockInter;
+    MainPanelControl *m_panel;
+    QList<DockItem *> m_items;
+    QJsonArray m_allocations;
+};
+
+void Bench_MainPanelControl::initTestCase()
+{
+    m_panel = nullptr;
+
+    // 使用任务栏后端服务的替身，不需要真实的任务栏服务
+    m_daemon = new MockDockDaemon(this);
+    if (!m_daemon->start())
+        QSKIP("org.deepin.dde.daemon.Dock1 is already registered, run the benchmark with dbus-run-session");
+
+    m_dockInter = new DockInter(dockServiceName(), dockServicePath(), QDBusConnection::sessionBus(), this);
+}
+
+void Bench_MainPanelControl::cleanupTestCase()
+{
+    destroyPanel();
+
+    const QString outputFile = qEnvironmentVariable("DOCK_BENCHMARK_OUTPUT", "mainpanelcontrol-allocations.json");
+    QFile file(outputFile);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        file.write(QJsonDocument(m_allocations).toJson());
+}
+
+void Bench_MainPanelControl::addRows()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("displayMode");
+    QTest::addColumn<int>("position");
+
+    static const QList<int> counts { 10, 50, 100, 200, 500 };
+    static const QList<QPair<int, const char *>> displayModes { { Dock::Efficient, "efficient" }, { Dock::Fashion, "fashion" } };
+    static const QList<QPair<int, const char *>> positions { { Dock::Bottom, "bottom" }, { Dock::Top, "top" }, { Dock::Left, "left" }, { Dock::Right, "right" } };
+    for (int count : counts) {
+        for (const auto &displayMode : displayModes) {
+            for (const auto &position : positions) {
+                const QByteArray name = QByteArray::number(count) + "/" + displayMode.second + "/" + position.second;
+                QTest::newRow(name.constData()) << count << displayMode.first << position.first;
+            }
+        }
+    }
+}
+
+MainPanelControl *Bench_MainPanelControl::createPanel()
+{
+    QFETCH(int, count);
+    QFETCH(int, displayMode);
+    QFETCH(int, position);
+
+    destroyPanel();
+
+    m_daemon->setDockProperty("DisplayMode", displayMode);
+    m_daemon->setDockProperty("Position", position);
+    qApp->setProperty(PROP_DISPLAY_MODE, QVariant::fromValue(static_cast<Dock::DisplayMode>(displayMode)));
+    qApp->setProperty(PROP_POSITION, QVariant::fromValue(static_cast<Dock::Position>(position)));
+
+    m_panel = new MainPanelControl(m_dockInter);
+    m_panel->setDisplayMode(static_cast<Dock::DisplayMode>(displayMode));
+    m_panel->setPositonValue(static_cast<Dock::Position>(position));
+    if (position == Dock::Top || position == Dock::Bottom)
+        m_panel->resize(1920, 48);
+    else
+        m_panel->resize(48, 1080);
+
+    m_panel->show();
+    fillItems(count);
+    flushLayout();
+
+    return m_panel;
+}
+
+void Bench_MainPanelControl::destroyPanel()
+{
+    delete m_panel;
+    m_panel = nullptr;
+
+    qDeleteAll(m_items);
+    m_items.clear();
+}
+
+void Bench_MainPanelControl::fillItems(int count)
+{
+    // 固定区域放少量插件图标，其余的都放在应用区域
+    for (int i = 0; i < count; ++i) {
+        DockItem *item = new BenchDockItem(i < 5 ? DockItem::FixedPlugin : DockItem::Placeholder);
+        m_items << item;
+        m_panel->insertItem(-1, item);
+    }
+}
+
+void Bench_MainPanelControl::flushLayout()
+{
+    // 图标大小的计算是在下一轮事件循环中合并执行的
+    QCoreApplication::sendPostedEvents();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::LayoutRequest);
+}
+
+void Bench_MainPanelControl::recordAllocations(const char *operation, quint64 allocations)
+{
+    QFETCH(int, count);
+    QFETCH(int, displayMode);
+    QFETCH(int, position);
+
+    QJsonObject result;
+    result.insert("operation", operation);
+    result.insert("count", count);
+    result.insert("displayMode", displayMode);
+    result.insert("position", position);
+    result.insert("allocations", static_cast<qint64>(allocations));
+    m_allocations.append(result);
+}
+
+void Bench_MainPanelControl::insertItem()
+{
+    createPanel();
+
+    DockItem *item = new BenchDockItem(DockItem::Placeholder);
+    m_items << item;
+
+    quint64 allocations = g_allocationCount;
+    m_panel->insertItem(-1, item);
+    flushLayout();
+    recordAllocations("insertItem", g_allocationCount - allocations);
+    m_panel->removeItem(item);
+    flushLayout();
+
+    QBENCHMARK {
+        m_panel->insertItem(-1, item);
+        flushLayout();
+        m_panel->removeItem(item);
+        flushLayout();
+    }
+}
+
+void Bench_MainPanelControl::removeItem()
+{
+    createPanel();
+
+    DockItem *item = m_items.last();
+
+    quint64 allocations = g_allocationCount;
+    m_panel->removeItem(item);
+    flushLayout();
+    recordAllocations("removeItem", g_allocationCount - allocations);
+    m_panel->insertItem(-1, item);
+    flushLayout();
+
+    QBENCHMARK {
+        m_panel->removeItem(item);
+        flushLayout();
+        m_panel->insertItem(-1, item);
+        flushLayout();
+    }
+}
+
+void Bench_MainPanelControl::moveItem()
+{
+    createPanel();
+
+    // 在固定区域中来回交换两个图标的位置
+    DockItem *first = m_items.at(0);
+    DockItem *second = m_items.at(1);
+
+    quint64 allocations = g_allocationCount;
+    m_panel->moveItem(first, second);
+    flushLayout();
+    recordAllocations("moveItem", g_allocationCount - allocations);
+
+    QBENCHMARK {
+        m_panel->moveItem(second, first);
+        flushLayout();
+        m_panel->moveItem(first, second);
+        flushLayout();
+    }
+}
+
+void Bench_MainPanelControl::resizeDockIconFull()
+{
+    createPanel();
+
+    auto fullLayout = [ this ] {
+        // 清空缓存，强制所有区域重新计算
+        m_panel->m_layoutState.size = QSize();
+        m_panel->m_areaLayoutCache.clear();
+        m_panel->resizeDockIcon();
+        flushLayout();
+    };
+
+    quint64 allocations = g_allocationCount;
+    fullLayout();
+    recordAllocations("resizeDockIconFull", g_allocationCount - allocations);
+
+    QBENCHMARK {
+        fullLayout();
+    }
+}
+
+void Bench_MainPanelControl::resizeDockIconIncremental()
+{
+    createPanel();
+
+    quint64 allocations = g_allocationCount;
+    m_panel->resizeDockIcon();
+    flushLayout();
+    recordAllocations("resizeDockIconIncremental", g_allocationCount - allocations);
+
+    QBENCHMARK {
+        m_panel->resizeDockIcon();
+        flushLayout();
+    }
+}
+
+void Bench_MainPanelControl::repaint()
+{
+    createPanel();
+
+    QPixmap pixmap(m_panel->size());
+    quint64 allocations = g_allocationCount;
+    m_panel->render(&pixmap);
+    recordAllocations("repaint", g_allocationCount - allocations);
+
+    QBENCHMARK {
+        m_panel->render(&pixmap);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    DockApplication app(argc, argv);
+    // 设置应用名为dde-dock，否则dconfig相关的配置就读不到了
+    app.setApplicationName("dde-dock");
+    qApp->setProperty("CANSHOW", true);
+
+    Bench_MainPanelControl benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "bench_mainpanelcontrol.moc"
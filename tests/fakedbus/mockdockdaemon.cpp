@@ -0,0 +1,597 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mockdockdaemon.h"
+#include "dockinterface.h"
+#include "dbusutil.h"
+#include "constants.h"
+
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDBusObjectPath>
+#include <QTimer>
+
+#define MOCK_CONNECTION_NAME "dde-dock-mock-daemon"
+#define MOCK_WINDOW_ID_BASE 0x4000000
+
+static const QString PropertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+static const QString IntrospectableInterface = QStringLiteral("org.freedesktop.DBus.Introspectable");
+
+MockDBusObject::MockDBusObject(const QString &path, const QString &interface, MockDockDaemon *daemon, QObject *parent)
+    : QDBusVirtualObject(parent)
+    , m_path(path)
+    , m_interface(interface)
+    , m_daemon(daemon)
+    , m_exported(false)
+{
+}
+
+void MockDBusObject::setValue(const QString &name, const QVariant &value)
+{
+    setValues(QVariantMap {{ name, value }});
+}
+
+/**
+ * @brief MockDBusObject::setValues 修改属性，多个属性的变化在同一个PropertiesChanged信号中发出
+ */
+void MockDBusObject::setValues(const QVariantMap &values)
+{
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it)
+        m_properties[it.key()] = it.value();
+
+    // 注册到总线之前设置的是初始值，不需要发出变化的信号
+    if (!m_exported)
+        return;
+
+    QDBusMessage message = QDBusMessage::createSignal(m_path, PropertiesInterface, QStringLiteral("PropertiesChanged"));
+    message << m_interface << values << QStringList();
+    m_daemon->connection().send(message);
+}
+
+void MockDBusObject::addMethod(const QString &name, MethodHandler handler)
+{
+    m_methods[name] = handler;
+}
+
+void MockDBusObject::emitSignal(const QString &name, const QVariantList &arguments)
+{
+    QDBusMessage message = QDBusMessage::createSignal(m_path, m_interface, name);
+    message.setArguments(arguments);
+    m_daemon->connection().send(message);
+}
+
+QString MockDBusObject::introspect(const QString &path) const
+{
+    Q_UNUSED(path);
+
+    QString xml = QString("  <interface name=\"%1\">\n").arg(m_interface);
+    for (auto it = m_methods.constBegin(); it != m_methods.constEnd(); ++it)
+        xml += QString("    <method name=\"%1\"/>\n").arg(it.key());
+
+    for (auto it = m_properties.constBegin(); it != m_properties.constEnd(); ++it) {
+        const char *signature = QDBusMetaType::typeToSignature(it.value().userType());
+        xml += QString("    <property name=\"%1\" type=\"%2\" access=\"read\"/>\n").arg(it.key()).arg(QString::fromLatin1(signature));
+    }
+    xml += "  </interface>\n";
+
+    return xml;
+}
+
+/**
+ * @brief MockDBusObject::handleMessage 这个函数在QtDBus自己的线程中调用，转到对象所在的线程中处理
+ */
+bool MockDBusObject::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    Q_UNUSED(connection);
+
+    if (message.interface() == IntrospectableInterface)
+        return false;
+
+    QMetaObject::invokeMethod(this, [ this, message ] {
+        dispatch(message);
+    }, Qt::QueuedConnection);
+
+    return true;
+}
+
+void MockDBusObject::dispatch(const QDBusMessage &message)
+{
+    const QString member = message.member();
+    const QVariantList arguments = message.arguments();
+
+    QDBusMessage reply;
+    if (message.interface() == PropertiesInterface) {
+        const QString name = arguments.value(1).toString();
+        if (member == "GetAll") {
+            m_daemon->recordCall(member);
+            reply = message.createReply(QVariant::fromValue(m_properties));
+        } else if (member == "Get" && m_properties.contains(name)) {
+            m_daemon->recordCall(QString("Get(%1)").arg(name));
+            reply = message.createReply(QVariant::fromValue(QDBusVariant(m_properties.value(name))));
+        } else if (member == "Set" && m_properties.contains(name)) {
+            m_daemon->recordCall(QString("Set(%1)").arg(name));
+            setValue(name, arguments.value(2).value<QDBusVariant>().variant());
+            reply = message.createReply();
+        } else {
+            reply = message.createErrorReply(QDBusError::InvalidArgs, QString("no such property: %1").arg(name));
+        }
+    } else if (m_methods.contains(member)) {
+        m_daemon->recordCall(member);
+        const MethodHandler &handler = m_methods[member];
+        reply = handler ? message.createReply(handler(arguments)) : message.createReply();
+    } else {
+        reply = message.createErrorReply(QDBusError::UnknownMethod, QString("no such method: %1").arg(member));
+    }
+
+    m_daemon->sendReply(reply);
+}
+
+MockDockEntry::MockDockEntry(const QString &path, const QString &id, MockDockDaemon *daemon, QObject *parent)
+    : MockDBusObject(path, Dock_Entry::staticInterfaceName(), daemon, parent)
+    , m_id(id)
+{
+    setValues({
+        { "CurrentWindow", 0u },
+        { "DesktopFile", QString("/usr/share/applications/%1.desktop").arg(id) },
+        { "Icon", id },
+        { "Id", id },
+        { "IsActive", false },
+        { "IsDocked", false },
+        { "Menu", QString() },
+        { "Name", id },
+        { "WindowInfos", QVariant::fromValue(WindowInfoMap()) },
+        { "Mode", 0 }
+    });
+
+    for (const QString &method : { "Activate", "Check", "ForceQuit", "ActiveWindow", "HandleDragDrop",
+                                   "HandleMenuItem", "NewInstance", "PresentWindows", "RequestDock", "RequestUndock" })
+        addMethod(method);
+
+    addMethod("GetAllowedCloseWindows", [ this ](const QVariantList &) {
+        return QVariantList { QVariant::fromValue(WindowList(m_windowInfos.keys())) };
+    });
+}
+
+void MockDockEntry::addWindow(quint32 xid, const QString &title)
+{
+    WindowInfo info;
+    info.attention = false;
+    info.title = title;
+    info.uuid = QString::number(xid);
+    m_windowInfos.insert(xid, info);
+
+    updateWindowInfos();
+}
+
+void MockDockEntry::removeWindow(quint32 xid)
+{
+    if (m_windowInfos.remove(xid))
+        updateWindowInfos();
+}
+
+void MockDockEntry::setWindowTitle(quint32 xid, const QString &title)
+{
+    if (!m_windowInfos.contains(xid))
+        return;
+
+    m_windowInfos[xid].title = title;
+    updateWindowInfos();
+}
+
+void MockDockEntry::setWindowAttention(quint32 xid, bool attention)
+{
+    if (!m_windowInfos.contains(xid))
+        return;
+
+    m_windowInfos[xid].attention = attention;
+    updateWindowInfos();
+}
+
+void MockDockEntry::updateWindowInfos()
+{
+    QVariantMap values { { "WindowInfos", QVariant::fromValue(m_windowInfos) } };
+    const uint currentWindow = m_windowInfos.isEmpty() ? 0 : m_windowInfos.firstKey();
+    if (value("CurrentWindow").toUInt() != currentWindow)
+        values["CurrentWindow"] = currentWindow;
+
+    setValues(values);
+}
+
+MockDockDaemon::MockDockDaemon(QObject *parent)
+    : QObject(parent)
+    , m_context(nullptr)
+    , m_connection(QString())
+    , m_dock(nullptr)
+    , m_entryIndex(0)
+    , m_nextWindowId(MOCK_WINDOW_ID_BASE)
+    , m_latency(0)
+{
+    m_thread.setObjectName("MockDockDaemon");
+}
+
+MockDockDaemon::~MockDockDaemon()
+{
+    stop();
+}
+
+/**
+ * @brief MockDockDaemon::start 启动服务线程并注册org.deepin.dde.daemon.Dock1服务
+ * @return 注册服务失败(比如真实的后端服务已经在运行)的时候返回false
+ */
+bool MockDockDaemon::start()
+{
+    if (isRunning())
+        return true;
+
+    registerWindowListMetaType();
+    registerWindowInfoMapMetaType();
+    registerDockRectMetaType();
+
+    m_thread.start();
+    m_context = new QObject;
+    m_context->moveToThread(&m_thread);
+
+    bool registered = false;
+    invoke([ this, &registered ] {
+        m_connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, MOCK_CONNECTION_NAME);
+        if (!m_connection.isConnected())
+            return;
+
+        m_dock = new MockDBusObject(dockServicePath(), Dde_Dock::staticInterfaceName(), this, m_context);
+        initDock();
+
+        registered = m_connection.registerVirtualObject(dockServicePath(), m_dock)
+                && m_connection.registerService(dockServiceName());
+        m_dock->setExported(registered);
+    });
+
+    if (!registered) {
+        qWarning() << "register mock dock daemon failed:" << m_connection.lastError().message();
+        stop();
+    }
+
+    return registered;
+}
+
+void MockDockDaemon::stop()
+{
+    if (!isRunning())
+        return;
+
+    invoke([ this ] {
+        if (m_connection.isConnected()) {
+            m_connection.unregisterService(dockServiceName());
+            m_connection.unregisterObject(dockServicePath());
+            for (const QString &path : m_entries.keys())
+                m_connection.unregisterObject(path);
+        }
+
+        qDeleteAll(m_context->children());
+        m_dock = nullptr;
+        m_entries.clear();
+        m_entryOrder.clear();
+
+        QDBusConnection::disconnectFromBus(MOCK_CONNECTION_NAME);
+        m_connection = QDBusConnection(QString());
+    });
+
+    m_thread.quit();
+    m_thread.wait();
+
+    delete m_context;
+    m_context = nullptr;
+}
+
+void MockDockDaemon::setDockProperty(const QString &name, const QVariant &value)
+{
+    invoke([ = ] {
+        m_dock->setValue(name, value);
+    });
+}
+
+QVariant MockDockDaemon::dockProperty(const QString &name) const
+{
+    QVariant value;
+    invoke([ & ] {
+        value = m_dock->value(name);
+    });
+
+    return value;
+}
+
+/**
+ * @brief MockDockDaemon::addEntry 添加一个应用，发出EntryAdded信号
+ * @return 应用的DBus路径
+ */
+QString MockDockDaemon::addEntry(const QString &id, int windowCount)
+{
+    QString path;
+    invoke([ & ] {
+        path = doAddEntry(id, windowCount);
+    });
+
+    return path;
+}
+
+void MockDockDaemon::removeEntry(const QString &path)
+{
+    invoke([ = ] {
+        doRemoveEntry(path);
+    });
+}
+
+QStringList MockDockDaemon::createEntries(int count, int windowsPerEntry)
+{
+    QStringList paths;
+    invoke([ & ] {
+        for (int i = 0; i < count; ++i)
+            paths << doAddEntry(QString("mock-app-%1").arg(m_entryIndex), windowsPerEntry);
+    });
+
+    return paths;
+}
+
+QStringList MockDockDaemon::entries() const
+{
+    QStringList paths;
+    invoke([ & ] {
+        paths = m_entryOrder;
+    });
+
+    return paths;
+}
+
+quint32 MockDockDaemon::addWindow(const QString &entryPath, const QString &title)
+{
+    quint32 xid = 0;
+    invoke([ & ] {
+        if (MockDockEntry *entry = m_entries.value(entryPath)) {
+            xid = m_nextWindowId++;
+            entry->addWindow(xid, title);
+        }
+    });
+
+    return xid;
+}
+
+void MockDockDaemon::removeWindow(const QString &entryPath, quint32 xid)
+{
+    invoke([ = ] {
+        if (MockDockEntry *entry = m_entries.value(entryPath))
+            entry->removeWindow(xid);
+    });
+}
+
+void MockDockDaemon::setWindowTitle(const QString &entryPath, quint32 xid, const QString &title)
+{
+    invoke([ = ] {
+        if (MockDockEntry *entry = m_entries.value(entryPath))
+            entry->setWindowTitle(xid, title);
+    });
+}
+
+void MockDockDaemon::setWindowAttention(const QString &entryPath, quint32 xid, bool attention)
+{
+    invoke([ = ] {
+        if (MockDockEntry *entry = m_entries.value(entryPath))
+            entry->setWindowAttention(xid, attention);
+    });
+}
+
+WindowInfoMap MockDockDaemon::windowInfos(const QString &entryPath) const
+{
+    WindowInfoMap infos;
+    invoke([ & ] {
+        if (MockDockEntry *entry = m_entries.value(entryPath))
+            infos = entry->windowInfos();
+    });
+
+    return infos;
+}
+
+/**
+ * @brief MockDockDaemon::startTitleStorm 以hz的频率修改每个应用第一个窗口的标题，持续durationMsecs毫秒后发出stormFinished
+ */
+void MockDockDaemon::startTitleStorm(int hz, int durationMsecs)
+{
+    startStorm(TitleStorm, hz, durationMsecs);
+}
+
+/**
+ * @brief MockDockDaemon::startAttentionStorm 以hz的频率切换每个应用第一个窗口的提醒状态，持续durationMsecs毫秒后发出stormFinished
+ */
+void MockDockDaemon::startAttentionStorm(int hz, int durationMsecs)
+{
+    startStorm(AttentionStorm, hz, durationMsecs);
+}
+
+/**
+ * @brief MockDockDaemon::entryBurst 连续添加count个应用后立即全部移除，模拟批量启动又退出的程序
+ */
+void MockDockDaemon::entryBurst(int count)
+{
+    invoke([ = ] {
+        QStringList paths;
+        for (int i = 0; i < count; ++i)
+            paths << doAddEntry(QString("mock-burst-%1").arg(m_entryIndex), 1);
+
+        for (const QString &path : paths)
+            doRemoveEntry(path);
+    });
+}
+
+int MockDockDaemon::callCount(const QString &member) const
+{
+    QMutexLocker locker(&m_callMutex);
+    return m_callCount.value(member);
+}
+
+void MockDockDaemon::resetCallCount()
+{
+    QMutexLocker locker(&m_callMutex);
+    m_callCount.clear();
+}
+
+void MockDockDaemon::recordCall(const QString &member)
+{
+    QMutexLocker locker(&m_callMutex);
+    m_callCount[member]++;
+}
+
+void MockDockDaemon::sendReply(const QDBusMessage &reply)
+{
+    const int latency = m_latency;
+    if (latency <= 0) {
+        m_connection.send(reply);
+        return;
+    }
+
+    QTimer::singleShot(latency, m_context, [ this, reply ] {
+        m_connection.send(reply);
+    });
+}
+
+/**
+ * @brief MockDockDaemon::invoke 在服务线程中执行并等待执行完成
+ */
+void MockDockDaemon::invoke(const std::function<void()> &function) const
+{
+    if (QThread::currentThread() == &m_thread) {
+        function();
+        return;
+    }
+
+    QMetaObject::invokeMethod(m_context, function, Qt::BlockingQueuedConnection);
+}
+
+void MockDockDaemon::initDock()
+{
+    m_dock->setValues({
+        { "DisplayMode", static_cast<int>(Dock::Efficient) },
+        { "DockedApps", QStringList() },
+        { "Entries", QVariant::fromValue(QList<QDBusObjectPath>()) },
+        { "FrontendWindowRect", QVariant::fromValue(DockRect()) },
+        { "HideMode", static_cast<int>(Dock::KeepShowing) },
+        { "HideState", static_cast<int>(Dock::Show) },
+        { "HideTimeout", 0u },
+        { "IconSize", 36u },
+        { "Opacity", 0.4 },
+        { "Position", static_cast<int>(Dock::Bottom) },
+        { "ShowTimeout", 0u },
+        { "WindowSize", 40u },
+        { "WindowSizeEfficient", 40u },
+        { "WindowSizeFashion", 48u },
+        { "ShowRecent", false },
+        { "ShowMultiWindow", false }
+    });
+
+    for (const QString &method : { "ActivateWindow", "PreviewWindow", "CancelPreviewWindow", "MinimizeWindow", "CloseWindow",
+                                   "MergePluginSettings", "MoveEntry", "RemovePluginSettings", "SetFrontendWindowRect", "SetPluginSettings" })
+        m_dock->addMethod(method);
+
+    m_dock->addMethod("GetDockedAppsDesktopFiles", [ this ](const QVariantList &) {
+        return QVariantList { m_dock->value("DockedApps") };
+    });
+    m_dock->addMethod("GetEntryIDs", [ this ](const QVariantList &) {
+        QStringList ids;
+        for (const QString &path : m_entryOrder)
+            ids << m_entries.value(path)->id();
+        return QVariantList { ids };
+    });
+    m_dock->addMethod("GetPluginSettings", [ ](const QVariantList &) {
+        return QVariantList { QString("{}") };
+    });
+    m_dock->addMethod("IsDocked", [ this ](const QVariantList &arguments) {
+        return QVariantList { m_dock->value("DockedApps").toStringList().contains(arguments.value(0).toString()) };
+    });
+    m_dock->addMethod("IsOnDock", [ this ](const QVariantList &arguments) {
+        return QVariantList { m_dock->value("DockedApps").toStringList().contains(arguments.value(0).toString()) };
+    });
+    m_dock->addMethod("QueryWindowIdentifyMethod", [ ](const QVariantList &) {
+        return QVariantList { QString("Mock") };
+    });
+    m_dock->addMethod("RequestDock", [ ](const QVariantList &) {
+        return QVariantList { true };
+    });
+    m_dock->addMethod("RequestUndock", [ ](const QVariantList &) {
+        return QVariantList { true };
+    });
+}
+
+void MockDockDaemon::startStorm(StormType type, int hz, int durationMsecs)
+{
+    invoke([ = ] {
+        QTimer *timer = new QTimer(m_context);
+        timer->setInterval(1000 / qMax(1, hz));
+
+        connect(timer, &QTimer::timeout, timer, [ = , tick = 0 ]() mutable {
+            ++tick;
+            for (MockDockEntry *entry : m_entries) {
+                const WindowInfoMap infos = entry->windowInfos();
+                if (infos.isEmpty())
+                    continue;
+
+                const quint32 xid = infos.firstKey();
+                if (type == TitleStorm)
+                    entry->setWindowTitle(xid, QString("%1 - %2").arg(entry->id()).arg(tick));
+                else
+                    entry->setWindowAttention(xid, !infos.first().attention);
+            }
+        });
+
+        QTimer::singleShot(durationMsecs, timer, [ this, timer ] {
+            timer->deleteLater();
+            Q_EMIT stormFinished();
+        });
+
+        timer->start();
+    });
+}
+
+QString MockDockDaemon::doAddEntry(const QString &id, int windowCount)
+{
+    const QString path = QString("%1/entries/e%2").arg(dockServicePath()).arg(m_entryIndex++);
+    MockDockEntry *entry = new MockDockEntry(path, id, this, m_context);
+    for (int i = 0; i < windowCount; ++i)
+        entry->addWindow(m_nextWindowId++, QString("%1 - %2").arg(id).arg(i));
+
+    if (!m_connection.registerVirtualObject(path, entry)) {
+        qWarning() << "register mock dock entry failed:" << path;
+        delete entry;
+        return QString();
+    }
+    entry->setExported(true);
+
+    m_entries.insert(path, entry);
+    m_entryOrder << path;
+    updateEntries();
+    m_dock->emitSignal("EntryAdded", { QVariant::fromValue(QDBusObjectPath(path)), m_entryOrder.size() - 1 });
+
+    return path;
+}
+
+void MockDockDaemon::doRemoveEntry(const QString &path)
+{
+    MockDockEntry *entry = m_entries.take(path);
+    if (!entry)
+        return;
+
+    m_entryOrder.removeAll(path);
+    entry->setExported(false);
+    m_connection.unregisterObject(path);
+    updateEntries();
+    m_dock->emitSignal("EntryRemoved", { entry->id() });
+
+    entry->deleteLater();
+}
+
+void MockDockDaemon::updateEntries()
+{
+    QList<QDBusObjectPath> paths;
+    for (const QString &path : m_entryOrder)
+        paths << QDBusObjectPath(path);
+
+    m_dock->setValue("Entries", QVariant::fromValue(paths));
+}
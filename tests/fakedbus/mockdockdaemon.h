@@ -0,0 +1,166 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef MOCKDOCKDAEMON_H
+#define MOCKDOCKDAEMON_H
+
+#include "entryinterface.h"
+
+#include <QDBusConnection>
+#include <QDBusVirtualObject>
+#include <QMutex>
+#include <QThread>
+#include <QHash>
+#include <QMap>
+
+#include <atomic>
+#include <functional>
+
+class MockDockDaemon;
+
+/** 测试用的DBus对象
+ * @brief The MockDBusObject class
+ * 属性保存在本地，修改后发出PropertiesChanged信号，方法调用交给注册的处理函数，
+ * 所有的回复都按照daemon设置的延迟发送，用来模拟后端响应慢的情况
+ */
+class MockDBusObject : public QDBusVirtualObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<QVariantList(const QVariantList &)> MethodHandler;
+
+    MockDBusObject(const QString &path, const QString &interface, MockDockDaemon *daemon, QObject *parent = nullptr);
+
+    QString path() const { return m_path; }
+    void setExported(bool exported) { m_exported = exported; }
+    QVariant value(const QString &name) const { return m_properties.value(name); }
+    void setValue(const QString &name, const QVariant &value);
+    void setValues(const QVariantMap &values);
+    void addMethod(const QString &name, MethodHandler handler = MethodHandler());
+    void emitSignal(const QString &name, const QVariantList &arguments = QVariantList());
+
+    QString introspect(const QString &path) const override;
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+private:
+    void dispatch(const QDBusMessage &message);
+
+private:
+    QString m_path;
+    QString m_interface;
+    MockDockDaemon *m_daemon;
+    bool m_exported;                                    // 是否已经注册到总线上
+    QVariantMap m_properties;
+    QMap<QString, MethodHandler> m_methods;
+};
+
+/** 任务栏上的一个应用
+ * @brief The MockDockEntry class
+ * 对应org.deepin.dde.daemon.Dock1.Entry接口，窗口的增减、标题和提醒状态的变化都会更新WindowInfos属性
+ */
+class MockDockEntry : public MockDBusObject
+{
+    Q_OBJECT
+
+public:
+    MockDockEntry(const QString &path, const QString &id, MockDockDaemon *daemon, QObject *parent = nullptr);
+
+    QString id() const { return m_id; }
+    WindowInfoMap windowInfos() const { return m_windowInfos; }
+
+    void addWindow(quint32 xid, const QString &title);
+    void removeWindow(quint32 xid);
+    void setWindowTitle(quint32 xid, const QString &title);
+    void setWindowAttention(quint32 xid, bool attention);
+
+private:
+    void updateWindowInfos();
+
+private:
+    QString m_id;
+    WindowInfoMap m_windowInfos;
+};
+
+/** 任务栏后端服务(org.deepin.dde.daemon.Dock1)的替身
+ * @brief The MockDockDaemon class
+ * 在单独的线程中使用单独的DBus连接注册服务，任务栏的同步调用不会因为服务和调用方在同一个线程而卡住，
+ * 需要在私有的会话总线上运行(例如 dbus-run-session)，避免和真实的后端服务冲突。
+ * 可以批量创建应用和窗口，模拟标题变化风暴、提醒状态风暴和应用的批量增删，并设置每次调用的响应延迟，
+ * 所有的公共接口都可以在测试线程中直接调用
+ */
+class MockDockDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MockDockDaemon(QObject *parent = nullptr);
+    ~MockDockDaemon() override;
+
+    bool start();
+    void stop();
+    bool isRunning() const { return m_thread.isRunning(); }
+
+    QDBusConnection connection() const { return m_connection; }
+
+    void setLatency(int msecs) { m_latency = msecs; }
+    int latency() const { return m_latency; }
+
+    void setDockProperty(const QString &name, const QVariant &value);
+    QVariant dockProperty(const QString &name) const;
+
+    QString addEntry(const QString &id, int windowCount = 0);
+    void removeEntry(const QString &path);
+    QStringList createEntries(int count, int windowsPerEntry);
+    QStringList entries() const;
+
+    quint32 addWindow(const QString &entryPath, const QString &title);
+    void removeWindow(const QString &entryPath, quint32 xid);
+    void setWindowTitle(const QString &entryPath, quint32 xid, const QString &title);
+    void setWindowAttention(const QString &entryPath, quint32 xid, bool attention);
+    WindowInfoMap windowInfos(const QString &entryPath) const;
+
+    void startTitleStorm(int hz, int durationMsecs);
+    void startAttentionStorm(int hz, int durationMsecs);
+    void entryBurst(int count);
+
+    int callCount(const QString &member) const;
+    void resetCallCount();
+
+    // 以下接口只在服务线程中使用
+    void recordCall(const QString &member);
+    void sendReply(const QDBusMessage &reply);
+
+Q_SIGNALS:
+    void stormFinished();
+
+private:
+    enum StormType {
+        TitleStorm,
+        AttentionStorm
+    };
+
+    void invoke(const std::function<void()> &function) const;
+    void initDock();
+    void startStorm(StormType type, int hz, int durationMsecs);
+    QString doAddEntry(const QString &id, int windowCount);
+    void doRemoveEntry(const QString &path);
+    void updateEntries();
+
+private:
+    QThread m_thread;
+    QObject *m_context;                                 // 服务线程中的对象都以它为父对象
+    QDBusConnection m_connection;
+    MockDBusObject *m_dock;
+    QMap<QString, MockDockEntry *> m_entries;           // key为应用的DBus路径
+    QStringList m_entryOrder;
+    int m_entryIndex;
+    quint32 m_nextWindowId;
+    std::atomic<int> m_latency;
+    mutable QMutex m_callMutex;
+    QHash<QString, int> m_callCount;
+};
+
+#endif // MOCKDOCKDAEMON_H
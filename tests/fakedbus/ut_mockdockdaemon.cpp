@@ -0,0 +1,116 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QElapsedTimer>
+#include <QTest>
+
+#include <gtest/gtest.h>
+
+#include "mockdockdaemon.h"
+#include "dbusutil.h"
+
+class Test_MockDockDaemon : public QObject, public ::testing::Test
+{
+public:
+    void SetUp() override;
+    void TearDown() override;
+
+    MockDockDaemon *daemon = nullptr;
+    DockInter *dockInter = nullptr;
+};
+
+void Test_MockDockDaemon::SetUp()
+{
+    daemon = new MockDockDaemon;
+    // 需要在私有的会话总线上运行，真实的后端服务在运行时跳过
+    if (!daemon->start())
+        GTEST_SKIP() << "org.deepin.dde.daemon.Dock1 is already registered";
+
+    dockInter = new DockInter(dockServiceName(), dockServicePath(), QDBusConnection::sessionBus());
+}
+
+void Test_MockDockDaemon::TearDown()
+{
+    delete dockInter;
+    delete daemon;
+}
+
+TEST_F(Test_MockDockDaemon, entries)
+{
+    QSignalSpy addedSpy(dockInter, &DockInter::EntryAdded);
+    QSignalSpy removedSpy(dockInter, &DockInter::EntryRemoved);
+
+    const QStringList paths = daemon->createEntries(3, 2);
+    ASSERT_EQ(paths.size(), 3);
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return addedSpy.count() == 3; }));
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return dockInter->entries().size() == 3; }));
+    ASSERT_EQ(dockInter->GetEntryIDs().value().size(), 3);
+
+    daemon->removeEntry(paths.first());
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return removedSpy.count() == 1; }));
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return dockInter->entries().size() == 2; }));
+
+    daemon->entryBurst(5);
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return addedSpy.count() == 8; }));
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return removedSpy.count() == 6; }));
+    ASSERT_EQ(daemon->entries().size(), 2);
+}
+
+TEST_F(Test_MockDockDaemon, windowInfos)
+{
+    const QString path = daemon->addEntry("deepin-terminal", 1);
+    DockEntryInter entryInter(dockServiceName(), path, QDBusConnection::sessionBus());
+    QSignalSpy spy(&entryInter, &DockEntryInter::WindowInfosChanged);
+
+    ASSERT_EQ(entryInter.id(), QString("deepin-terminal"));
+    ASSERT_EQ(entryInter.windowInfos().size(), 1);
+
+    const quint32 xid = daemon->addWindow(path, "second");
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return spy.count() == 1; }));
+    ASSERT_EQ(spy.last().first().value<WindowInfoMap>().size(), 2);
+
+    daemon->setWindowTitle(path, xid, "renamed");
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return spy.count() == 2; }));
+    ASSERT_EQ(spy.last().first().value<WindowInfoMap>().value(xid).title, QString("renamed"));
+
+    daemon->setWindowAttention(path, xid, true);
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return spy.count() == 3; }));
+    ASSERT_TRUE(spy.last().first().value<WindowInfoMap>().value(xid).attention);
+
+    ASSERT_EQ(entryInter.GetAllowedCloseWindows().value().size(), 2);
+}
+
+TEST_F(Test_MockDockDaemon, latency)
+{
+    daemon->setLatency(200);
+
+    QElapsedTimer timer;
+    timer.start();
+    QDBusPendingReply<QStringList> reply = dockInter->GetEntryIDs();
+    reply.waitForFinished();
+
+    ASSERT_FALSE(reply.isError());
+    ASSERT_GE(timer.elapsed(), 200);
+    ASSERT_EQ(daemon->callCount("GetEntryIDs"), 1);
+}
+
+TEST_F(Test_MockDockDaemon, storm)
+{
+    const QString path = daemon->createEntries(1, 1).first();
+    DockEntryInter entryInter(dockServiceName(), path, QDBusConnection::sessionBus());
+    QSignalSpy changedSpy(&entryInter, &DockEntryInter::WindowInfosChanged);
+    QSignalSpy finishedSpy(daemon, &MockDockDaemon::stormFinished);
+
+    daemon->startTitleStorm(30, 500);
+    ASSERT_TRUE(finishedSpy.wait(2000));
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return changedSpy.count() >= 10; }));
+
+    changedSpy.clear();
+    daemon->startAttentionStorm(30, 200);
+    ASSERT_TRUE(finishedSpy.wait(2000));
+    ASSERT_TRUE(QTest::qWaitFor([ & ] { return changedSpy.count() >= 3; }));
+}
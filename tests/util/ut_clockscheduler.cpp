@@ -0,0 +1,152 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QObject>
+#include <QDateTime>
+
+#include <gtest/gtest.h>
+
+#include "clockscheduler.h"
+
+/** 可以手动推进的时钟，推进时间的时候按顺序触发到期的唤醒
+ * @brief The FakeClockSource class
+ */
+class FakeClockSource : public ClockSource
+{
+public:
+    explicit FakeClockSource(const QDateTime &now)
+        : ClockSource(nullptr)
+        , m_now(now)
+    {
+    }
+
+    QDateTime currentDateTime() const override { return m_now; }
+    void wakeAt(const QDateTime &deadline) override { m_deadline = deadline; }
+    void cancel() override { m_deadline = QDateTime(); }
+
+    void advance(qint64 msecs)
+    {
+        const QDateTime target = m_now.addMSecs(msecs);
+        while (m_deadline.isValid() && m_deadline <= target) {
+            m_now = m_deadline;
+            m_deadline = QDateTime();
+            Q_EMIT timeout();
+        }
+        m_now = target;
+    }
+
+    // 模拟修改系统时间，timerfd会先取消掉已经设置的唤醒
+    void jumpTo(const QDateTime &now)
+    {
+        m_now = now;
+        m_deadline = QDateTime();
+        Q_EMIT clockChanged();
+    }
+
+    QDateTime deadline() const { return m_deadline; }
+
+private:
+    QDateTime m_now;
+    QDateTime m_deadline;
+};
+
+class Test_ClockScheduler : public QObject, public ::testing::Test
+{
+public:
+    void SetUp() override;
+    void TearDown() override;
+
+public:
+    FakeClockSource *clock = nullptr;
+    ClockScheduler *scheduler = nullptr;
+    int tickCount = 0;
+};
+
+void Test_ClockScheduler::SetUp()
+{
+    clock = new FakeClockSource(QDateTime(QDate(2023, 6, 1), QTime(10, 0, 30, 250), Qt::UTC));
+    scheduler = new ClockScheduler(clock);
+    tickCount = 0;
+    QObject::connect(scheduler, &ClockScheduler::tick, this, [ this ] { tickCount++; });
+}
+
+void Test_ClockScheduler::TearDown()
+{
+    delete scheduler;
+    scheduler = nullptr;
+    clock = nullptr;
+}
+
+TEST_F(Test_ClockScheduler, nextBoundary_test)
+{
+    const QDateTime now(QDate(2023, 6, 1), QTime(10, 0, 30, 250), Qt::UTC);
+    ASSERT_EQ(ClockScheduler::nextBoundary(now, ClockScheduler::Minute), QDateTime(QDate(2023, 6, 1), QTime(10, 1), Qt::UTC));
+    ASSERT_EQ(ClockScheduler::nextBoundary(now, ClockScheduler::Second), QDateTime(QDate(2023, 6, 1), QTime(10, 0, 31), Qt::UTC));
+
+    // 正好在边界上的时候等到下一个边界
+    const QDateTime boundary(QDate(2023, 6, 1), QTime(10, 1), Qt::UTC);
+    ASSERT_EQ(ClockScheduler::nextBoundary(boundary, ClockScheduler::Minute), boundary.addSecs(60));
+}
+
+TEST_F(Test_ClockScheduler, minuteWakeups_test)
+{
+    scheduler->start();
+    clock->advance(60 * 60 * 1000);
+
+    // 一个小时内只在整分钟唤醒60次
+    ASSERT_EQ(scheduler->wakeupCount(), 60u);
+    ASSERT_EQ(tickCount, 60);
+    ASSERT_EQ(clock->deadline(), QDateTime(QDate(2023, 6, 1), QTime(11, 1), Qt::UTC));
+}
+
+TEST_F(Test_ClockScheduler, secondWakeups_test)
+{
+    scheduler->setResolution(ClockScheduler::Second);
+    scheduler->start();
+    clock->advance(60 * 60 * 1000);
+
+    ASSERT_EQ(scheduler->wakeupCount(), 3600u);
+    ASSERT_EQ(tickCount, 3600);
+}
+
+TEST_F(Test_ClockScheduler, switchResolution_test)
+{
+    scheduler->start();
+
+    // 显示提示的5分钟内按秒刷新，其余时间按分钟刷新
+    clock->advance(10 * 60 * 1000);
+    scheduler->setResolution(ClockScheduler::Second);
+    clock->advance(5 * 60 * 1000);
+    scheduler->setResolution(ClockScheduler::Minute);
+    clock->advance(45 * 60 * 1000);
+
+    ASSERT_EQ(scheduler->wakeupCount(), 10u + 300u + 45u);
+}
+
+TEST_F(Test_ClockScheduler, clockChanged_test)
+{
+    scheduler->start();
+    clock->advance(30 * 1000);
+    ASSERT_EQ(tickCount, 1);
+
+    // 时间往回调整之后立即刷新，并且按照新的时间对齐
+    clock->jumpTo(QDateTime(QDate(2023, 6, 1), QTime(8, 15, 10), Qt::UTC));
+    ASSERT_EQ(tickCount, 2);
+    ASSERT_EQ(clock->deadline(), QDateTime(QDate(2023, 6, 1), QTime(8, 16), Qt::UTC));
+
+    clock->advance(50 * 1000);
+    ASSERT_EQ(tickCount, 3);
+}
+
+TEST_F(Test_ClockScheduler, stop_test)
+{
+    scheduler->start();
+    scheduler->stop();
+    ASSERT_FALSE(clock->deadline().isValid());
+
+    clock->advance(60 * 60 * 1000);
+    ASSERT_EQ(scheduler->wakeupCount(), 0u);
+    ASSERT_EQ(tickCount, 0);
+}
@@ -0,0 +1,53 @@
+// Copyright (C) 2023 ~ 2023 Deepin Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QCoreApplication>
+#include <QObject>
+#include <QX11Info>
+
+#include <gtest/gtest.h>
+
+#include <X11/Xatom.h>
+#include <xcb/xcb.h>
+
+#include "x11atoms.h"
+
+class Test_X11Atoms : public QObject, public ::testing::Test
+{};
+
+TEST_F(Test_X11Atoms, atom_test)
+{
+    if (!QX11Info::isPlatformX11())
+        GTEST_SKIP() << "not running on X11";
+
+    X11Atoms *atoms = X11Atoms::instance();
+
+    // 预定义的atom值是固定的
+    ASSERT_EQ(atoms->atom(X11Atoms::WM_CLASS), static_cast<quint32>(XA_WM_CLASS));
+    ASSERT_EQ(atoms->atom(X11Atoms::CARDINAL), static_cast<quint32>(XA_CARDINAL));
+
+    for (int i = 0; i < X11Atoms::AtomCount; ++i)
+        ASSERT_NE(atoms->atom(static_cast<X11Atoms::AtomType>(i)), 0u);
+
+    ASSERT_NE(atoms->atom(X11Atoms::NET_WM_STATE), atoms->atom(X11Atoms::NET_WM_STATE_HIDDEN));
+
+    // 按名称获取表中已有的atom时直接返回表中的值
+    ASSERT_EQ(atoms->atom(QByteArray("_NET_WM_STATE_HIDDEN")), atoms->atom(X11Atoms::NET_WM_STATE_HIDDEN));
+    ASSERT_EQ(atoms->atom(QByteArray("WM_CLASS")), static_cast<quint32>(XA_WM_CLASS));
+
+    // 不在表中的atom不会被创建，不存在时返回0并且不缓存，创建之后可以获取到
+    const QByteArray extraName = QByteArray("_DDE_DOCK_TEST_ATOM_") + QByteArray::number(QCoreApplication::applicationPid());
+    ASSERT_EQ(atoms->atom(extraName), 0u);
+
+    xcb_connection_t *connection = QX11Info::connection();
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(connection, xcb_intern_atom(connection, false, static_cast<uint16_t>(extraName.size()), extraName.constData()), nullptr);
+    ASSERT_TRUE(reply);
+    const quint32 extra = reply->atom;
+    free(reply);
+
+    ASSERT_NE(extra, 0u);
+    ASSERT_EQ(atoms->atom(extraName), extra);
+    ASSERT_EQ(atoms->atom(QByteArray()), 0u);
+}